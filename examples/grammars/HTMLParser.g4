@@ -36,24 +36,15 @@ options { tokenVocab=HTMLLexer;
           dot=any_unicode_char;}
 
 @header {
-def html_space_serializer(root):
+def html_space_separator(parent, node):
+    if (isinstance(node, UnparserRule) and
+        node.name == 'htmlTagName' and node.right_sibling and node.right_sibling.name == 'htmlAttribute' or node.name == 'htmlAttribute') \
+            or isinstance(node, UnlexerRule) and node.src and node.src.endswith(('<script', '<style', '<?xml')):
+        return ' '
+    return None
 
-    def _walk(node):
-        nonlocal src
-        for child in node.children:
-            _walk(child)
 
-        if isinstance(node, UnlexerRule) and node.src:
-            src += node.src
-
-        if (isinstance(node, UnparserRule) and
-            node.name == 'htmlTagName' and node.right_sibling and node.right_sibling.name == 'htmlAttribute' or node.name == 'htmlAttribute') \
-                or isinstance(node, UnlexerRule) and node.src and node.src.endswith(('<script', '<style', '<?xml')):
-            src += ' '
-
-    src = ''
-    _walk(root)
-    return src
+html_space_serializer = Serializer(separator=html_space_separator)
 
 }
 
@@ -12,6 +12,7 @@ import sys
 import antlerinator
 
 from .pkgdata import __version__, default_antlr_path
+from .runtime import Tree
 
 logger = logging.getLogger('grammarinator')
 
@@ -59,6 +60,15 @@ def add_disable_cleanup_argument(parser):
                         help='disable the removal of intermediate files.')
 
 
+def add_tree_format_argument(parser):
+    parser.add_argument('--tree-format', metavar='EXT', choices=sorted(ext[1:] for ext in Tree.codecs), default=Tree.extension[1:],
+                        help='format (and file extension) of the saved trees (choices: %(choices)s; default: %(default)s).')
+
+
+def process_tree_format_argument(args):
+    Tree.extension = '.' + args.tree_format
+
+
 def add_sys_path_argument(parser):
     parser.add_argument('--sys-path', metavar='DIR', action='append', default=[],
                         help='add directory to the search path for Python modules (may be specified multiple times)')
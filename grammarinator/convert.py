@@ -0,0 +1,97 @@
+# Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+#
+# Licensed under the BSD 3-Clause License
+# <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+# This file may not be copied, modified, or distributed except
+# according to those terms.
+
+import glob
+import os
+
+from argparse import ArgumentParser
+from multiprocessing import Pool
+from os.path import basename, isdir, join, splitext
+
+from .cli import add_jobs_argument, add_log_level_argument, add_tree_format_argument, add_version_argument, logger, process_log_level_argument, process_tree_format_argument
+from .population import is_population_file, open_population
+from .runtime import Tree
+
+
+# Output populations opened by the process (subtree stores are only read once
+# per process this way).
+_populations = dict()
+
+
+def convert_tree(fn, out, extension, remove):
+    """
+    Convert a saved tree to another format.
+
+    :param fn: Path of the tree file to convert.
+    :param out: Output directory, population database or subtree store (None
+        to save next to the input).
+    :param extension: Extension of the target format.
+    :param remove: Remove the input file after a successful conversion.
+    """
+    root, ext = splitext(fn)
+    if ext == extension and not (out and is_population_file(out)):
+        return
+
+    target = join(out, basename(root)) if out else root
+    try:
+        tree = Tree.load(fn)
+        if out and is_population_file(out):
+            population = _populations.get(out)
+            if population is None:
+                population = _populations[out] = open_population(out)
+            population.add_tree(tree)
+        else:
+            tree.save(target + extension)
+        if remove:
+            os.remove(fn)
+        logger.debug('Converted %s to %s.', fn, target + extension)
+    except Exception as e:
+        logger.warning('Exception while converting %s.', fn, exc_info=e)
+
+
+def iterate_trees(inputs, out, extension, remove):
+    for path in inputs:
+        files = [fn for ext in Tree.codecs for fn in glob.glob(join(path, '*' + ext))] if isdir(path) else [path]
+        for fn in files:
+            yield (fn, out, extension, remove)
+
+
+def execute():
+    parser = ArgumentParser(description='Grammarinator: Convert',
+                            epilog="""
+                            The tool converts saved tree representations (e.g., a population
+                            of legacy pickled .grt files) to another tree format, or collects
+                            them into a population database.
+                            """)
+    parser.add_argument('input', metavar='FILE', nargs='+',
+                        help='tree files or directories of tree files to convert.')
+    parser.add_argument('-o', '--out', metavar='DIR',
+                        help='directory (or population database file with .grdb extension, or subtree store file with .grss extension) to save the converted trees (default: next to the input files).')
+    parser.add_argument('--remove', action='store_true', default=False,
+                        help='remove the input files after successful conversion.')
+    add_tree_format_argument(parser)
+    add_jobs_argument(parser)
+    add_log_level_argument(parser)
+    add_version_argument(parser)
+    args = parser.parse_args()
+
+    process_log_level_argument(args)
+    process_tree_format_argument(args)
+
+    if args.out and not is_population_file(args.out):
+        os.makedirs(args.out, exist_ok=True)
+
+    if args.jobs > 1:
+        with Pool(args.jobs) as pool:
+            pool.starmap(convert_tree, iterate_trees(args.input, args.out, Tree.extension, args.remove))
+    else:
+        for convert_args in iterate_trees(args.input, args.out, Tree.extension, args.remove):
+            convert_tree(*convert_args)
+
+
+if __name__ == '__main__':
+    execute()
@@ -11,43 +11,34 @@ import importlib
 import json
 import os
 import random
+import socket
+import struct
+import sys
+import tempfile
+import time
 
 from argparse import ArgumentParser, ArgumentTypeError
+from contextlib import contextmanager
+from hashlib import blake2b
+from itertools import count, islice
 from math import inf
-from multiprocessing import Pool
-from os.path import abspath, basename, dirname, isdir, join, splitext
+from multiprocessing import Pool, util
+from os.path import abspath, basename, dirname, exists, isdir, join, splitext
 from shutil import rmtree
 
-from .cli import add_jobs_argument, add_log_level_argument, add_sys_path_argument, add_sys_recursion_limit_argument, add_version_argument, logger, process_log_level_argument, process_sys_path_argument, process_sys_recursion_limit_argument
-from .model import CooldownModel
-from .runtime import Tree
-
-
-class Population(object):
-
-    def __init__(self, directory):
-        self.directory = directory
-        self.tree_extension = Tree.extension
-        os.makedirs(directory, exist_ok=True)
-        self.obj_list = glob.glob(join(self.directory, '*' + Tree.extension))
-
-    def random_individuals(self, n=1):
-        return random.sample(self.obj_list, n)
-
-    def add_tree(self, fn):
-        self.obj_list.append(fn)
-
-    @property
-    def size(self):
-        return len(self.obj_list)
+from .cli import add_jobs_argument, add_log_level_argument, add_sys_path_argument, add_sys_recursion_limit_argument, add_tree_format_argument, add_version_argument, logger, process_log_level_argument, process_sys_path_argument, process_sys_recursion_limit_argument, process_tree_format_argument
+from .model import CooldownCounts, CooldownModel, DefaultModel, SizeModel
+from .population import is_population_file, open_population
+from .runtime import BudgetExceededError, find_repetitions, FlatRule, LazyTree, ProfilingListener, Serializer, Tree, UnlexerRule
 
 
 class Generator(object):
 
     def __init__(self, generator, rule, out_format,
-                 model=None, listeners=None, max_depth=inf, cooldown=1.0,
-                 population=None, generate=True, mutate=True, recombine=True, keep_trees=False,
-                 transformers=None, serializer=None,
+                 model=None, listeners=None, max_depth=inf, cooldown=1.0, target_size=None,
+                 population=None, population_cache=0, population_preload=False, generate=True, mutate=True, recombine=True, edit=True, keep_trees=False,
+                 transformers=None, serializer=None, flat_tree=False, profile=False,
+                 random_seed=None, model_weights=None, max_attempts=100, max_nodes=inf, max_bytes=inf, max_time=inf,
                  cleanup=True, encoding='utf-8'):
 
         def import_entity(name):
@@ -72,68 +63,265 @@ class Generator(object):
         self.serializer = import_entity(serializer) if serializer else str
         self.rule = rule or self.generator_cls.default_rule.__name__
 
-        out_dir = abspath(dirname(out_format))
-        os.makedirs(out_dir, exist_ok=True)
+        # Without output pattern, tests are only created in memory (see
+        # create_new_test_data).
+        if out_format:
+            out_dir = abspath(dirname(out_format))
+            os.makedirs(out_dir, exist_ok=True)
 
-        if '%d' not in out_format:
-            base, ext = splitext(out_format)
-            self.out_format = '{base}%d{ext}'.format(base=base, ext=ext) if ext else join(base, '%d')
-        else:
-            self.out_format = out_format
+            if '%d' not in out_format:
+                base, ext = splitext(out_format)
+                out_format = '{base}%d{ext}'.format(base=base, ext=ext) if ext else join(base, '%d')
+        self.out_format = out_format
 
         self.max_depth = float(max_depth)
         self.cooldown = float(cooldown)
+        self.target_size = int(target_size) if target_size else None
         self.weights = dict()
-        self.population = Population(population) if population else None
+        # Counters of the choices shared by the worker processes of a
+        # GeneratorPool (see CooldownCounts).
+        self.cooldown_counts = None
+        self.population = open_population(population, cache_size=int(population_cache)) if population else None
+        self.population_preload = get_boolean(population_preload)
         self.enable_generation = get_boolean(generate)
         self.enable_mutation = get_boolean(mutate)
         self.enable_recombination = get_boolean(recombine)
+        self.enable_edit = get_boolean(edit)
         self.keep_trees = get_boolean(keep_trees)
+        self.flat_tree = get_boolean(flat_tree)
+        self.profile = get_boolean(profile)
+        # With a master seed, every test is generated from its own seed
+        # derived from the master seed and the index of the test (see
+        # seed_test), independently of the process and of the tests generated
+        # before it.
+        self.random_seed = int(random_seed) if random_seed is not None else None
+        self._random = random.Random() if self.random_seed is not None else None
+        # File of the learned weights of the model (see FeedbackModel), loaded
+        # when the model is created and saved at exit.
+        self.model_weights = model_weights
+        self.max_attempts = int(max_attempts)
+        # Number of the successful and failed attempts of every strategy in
+        # the current process (see create_new_tree).
+        self.strategy_stats = dict()
+        # Budgets of the generator per generated tree (only the set ones are
+        # passed to the generator, see generate) and the number of the
+        # generations aborted because of exceeding them.
+        self.budgets = dict((name, value) for name, value in (('max_nodes', max_nodes), ('max_bytes', max_bytes), ('max_time', max_time)) if value is not None and value < inf)
+        self.budget_aborts = dict()
         self.cleanup = get_boolean(cleanup)
         self.encoding = encoding
+        # Model and listener instances, reused by all the tests generated in
+        # the process.
+        self._instances = dict()
+
+    def __getstate__(self):
+        state = self.__dict__.copy()
+        state['_instances'] = dict()
+        return state
 
     def __enter__(self):
         return self
 
     def __exit__(self, exc_type, exc_val, exc_tb):
-        if self.cleanup:
+        self.save_model_weights()
+        if self.cleanup and self.out_format:
             rmtree(dirname(self.out_format))
 
     def __call__(self, index, *args, **kwargs):
         return self.create_new_test(index)[0]
 
+    @property
+    def random(self):
+        """
+        Random number generator of the models (a random.Random object
+        seeded per test if a master seed is given, the global generator of the
+        random module otherwise).
+        """
+        return self._random or random
+
+    def test_seed(self, index):
+        """
+        Derive the seed of a test from the master seed and the index of the
+        test.
+        """
+        data = '{seed}:{index}'.format(seed=self.random_seed, index=index).encode('ascii')
+        return int.from_bytes(blake2b(data, digest_size=8).digest(), 'little')
+
+    def seed_test(self, index):
+        """
+        Seed the random number generators before generating a test (if a master
+        seed is given). Beside the generator of the models, the global
+        generator is also seeded (with a different seed), as it is used by the
+        strategies, the population, and possibly by custom models and
+        listeners.
+        """
+        if self.random_seed is None:
+            return
+        seed = self.test_seed(index)
+        self._random.seed(seed)
+        random.seed(seed ^ 0x5eed)
+
     def create_new_test(self, index):
-        generators = []
+        """
+        Create a new test and save it to the file given by the output pattern.
 
-        if self.enable_generation:
-            generators.append(self.generate)
+        :param index: Index of the test (substituted into the output pattern).
+        :return: Tuple of the name of the test file and the reference to the
+            tree in the population (None if trees are not kept).
+        """
+        test_fn = self.out_format % index
+        self.seed_test(index)
+        tree, tree_fn = self.create_new_tree(basename(test_fn))
 
+        with codecs.open(test_fn, 'w', self.encoding) as f:
+            if isinstance(self.serializer, Serializer):
+                self.serializer.write(tree.root, f)
+            else:
+                f.write(self.serialize(tree))
+
+        return test_fn, tree_fn
+
+    def create_new_test_data(self, index):
+        """
+        Create a new test in memory, without writing it to a file.
+
+        :param index: Index of the test (used to name the tree if it is kept in
+            a population).
+        :return: Tuple of the serialized and encoded test (bytes) and the
+            reference to the tree in the population (None if trees are not
+            kept).
+        """
+        self.seed_test(index)
+        tree, tree_fn = self.create_new_tree(basename(self.out_format % index) if self.out_format else str(index))
+        return self.serialize(tree).encode(self.encoding), tree_fn
+
+    def serialize(self, tree):
+        # str() of encoded trees (see EncodedTree) can be computed without
+        # building their nodes.
+        return str(tree) if self.serializer is str else self.serializer(tree.root)
+
+    def feedback(self, new_coverage, exec_time=None):
+        """
+        Report the result of executing the test created last by this process
+        (e.g., by create_new_test_data) to the model, if it supports learning
+        (see FeedbackModel).
+
+        :param new_coverage: Whether the test has reached new coverage in the
+            target.
+        :param exec_time: Execution time of the test (optional).
+        """
+        model = self._instances.get(self.model_cls)
+        if hasattr(model, 'feedback'):
+            model.feedback(new_coverage, exec_time)
+
+    def save_model_weights(self):
+        """
+        Save the learned weights of the model of this process into the model
+        weights file (if both are given). The models of the workers of a
+        GeneratorPool are not saved.
+        """
+        model = self._instances.get(self.model_cls)
+        if self.model_weights and hasattr(model, 'save'):
+            model.save(self.model_weights)
+
+    # Strategies are not chosen anymore if their success rate drops below
+    # this limit (after enough attempts to estimate it).
+    min_success_rate = 0.05
+    min_strategy_attempts = 20
+
+    def choose_strategy(self, strategies):
+        """
+        Choose a strategy randomly, weighted by the (smoothed) success rate of
+        the strategies. Strategies that fail almost always are only chosen if
+        all the strategies do so. Without adaptation (i.e., with a master
+        seed, to keep the tests independent of the earlier tests of the
+        process), the strategies are chosen uniformly.
+
+        :param strategies: List of the names of the available strategies.
+        :return: Name of the chosen strategy.
+        """
+        if self.random_seed is not None or len(strategies) == 1:
+            return random.choice(strategies)
+
+        weights = []
+        for strategy in strategies:
+            successes, failures = self.strategy_stats.get(strategy, (0, 0))
+            rate = (successes + 1) / (successes + failures + 2)
+            if successes + failures >= self.min_strategy_attempts and rate < self.min_success_rate:
+                rate = 0
+            weights.append(rate)
+        total = sum(weights)
+        if not total:
+            return random.choice(strategies)
+        target = random.random() * total
+        for strategy, weight in zip(strategies, weights):
+            target -= weight
+            if target < 0:
+                return strategy
+        return strategies[-1]
+
+    def log_strategy_stats(self):
+        """
+        Log the number of the successful and failed attempts of the strategies
+        in the current process.
+        """
+        for strategy, (successes, failures) in sorted(self.strategy_stats.items()):
+            logger.info('Strategy %s (pid %d): %d succeeded, %d failed (%.1f%%).', strategy, os.getpid(), successes, failures, 100 * failures / (successes + failures) if successes + failures else 0.0)
+        for budget, cnt in sorted(self.budget_aborts.items()):
+            logger.info('Budget of %s (pid %d): exceeded %d times.', budget, os.getpid(), cnt)
+
+    def create_new_tree(self, name):
+        strategies = []
+        if self.enable_generation:
+            strategies.append('generate')
         if self.population:
             if self.enable_mutation and self.population.size > 0:
-                generators.append(self.mutate)
+                strategies.append('mutate')
+            if self.enable_edit and self.population.size > 0:
+                strategies.append('edit')
             if self.enable_recombination and self.population.size > 1:
-                generators.append(self.recombine)
-
-        try:
-            generator = random.choice(generators)
-            tree = generator(self.rule, self.max_depth)
-        except Exception as e:
-            logger.warning('Test generation failed.', exc_info=e)
-            return self.create_new_test(index)
+                strategies.append('recombine')
+        if not strategies:
+            raise ValueError('No test generation strategy is available (generation is disabled and the population is too small).')
+
+        model = self._instances.get(self.model_cls)
+        for _ in range(self.max_attempts):
+            if hasattr(model, 'begin'):
+                model.begin()
+            strategy = self.choose_strategy(strategies)
+            stats = self.strategy_stats.get(strategy)
+            if stats is None:
+                stats = self.strategy_stats[strategy] = [0, 0]
+            try:
+                tree = getattr(self, strategy)(self.rule, self.max_depth)
+            except BudgetExceededError as e:
+                # Aborts are expected under budgets, they are only counted.
+                logger.debug('Test generation (%s) aborted: %s', strategy, e)
+                self.budget_aborts[e.budget] = self.budget_aborts.get(e.budget, 0) + 1
+                stats[1] += 1
+                continue
+            except Exception as e:
+                # Only the first failure of a strategy is logged with details,
+                # the rest are counted (see log_strategy_stats).
+                if not stats[1]:
+                    logger.warning('Test generation (%s) failed.', strategy, exc_info=e)
+                else:
+                    logger.debug('Test generation (%s) failed.', strategy, exc_info=e)
+                stats[1] += 1
+                continue
+            stats[0] += 1
+            break
+        else:
+            raise RuntimeError('Test generation failed {cnt} times in a row.'.format(cnt=self.max_attempts))
 
-        test_fn = self.out_format % index
-        tree.root = Generator.transform(tree.root, self.transformers)
+        if self.transformers:
+            tree.root = Generator.transform(tree.root, self.transformers)
 
         tree_fn = None
         if self.keep_trees:
-            tree_fn = join(self.population.directory, basename(test_fn) + Tree.extension)
-            self.population.add_tree(tree_fn)
-            tree.save(tree_fn)
+            tree_fn = self.population.add_tree(tree, name)
 
-        with codecs.open(test_fn, 'w', self.encoding) as f:
-            f.write(self.serializer(tree.root))
-
-        return test_fn, tree_fn
+        return tree, tree_fn
 
     @staticmethod
     def transform(root, transformers):
@@ -148,67 +336,446 @@ class Generator(object):
         elif start_rule.min_depth > max_depth:
             raise ValueError('{rule} cannot be generated within the given depth: {max_depth} (min needed: {depth}).'.format(rule=rule, max_depth=max_depth, depth=start_rule.min_depth))
 
-        instances = {}
-
         def instantiate(cls):
-            obj = instances.get(cls)
+            obj = self._instances.get(cls)
             if not obj:
                 obj = cls()
-                instances[cls] = obj
+                self._instances[cls] = obj
             return obj
 
-        model = instantiate(self.model_cls)
+        model = self._instances.get(self.model_cls)
+        if model is None:
+            # Models derived from DefaultModel share the generator of the
+            # test seeds (assigned after construction, as subclasses may
+            # define constructors without an rng parameter).
+            model = self.model_cls()
+            if isinstance(model, DefaultModel):
+                model.random = self.random
+            if self.model_weights and exists(self.model_weights) and hasattr(model, 'load'):
+                model.load(self.model_weights)
+            self._instances[self.model_cls] = model
         if self.cooldown < 1:
-            model = CooldownModel(model, cooldown=self.cooldown, weights=self.weights)
-        generator = self.generator_cls(model=model, max_depth=max_depth)
+            # The wrapper is reused as well to keep its cooled-down weight
+            # tables between tests.
+            cooldown_model = self._instances.get(CooldownModel)
+            if cooldown_model is None:
+                cooldown_model = CooldownModel(model, cooldown=self.cooldown, weights=self.weights, counts=self.cooldown_counts)
+                self._instances[CooldownModel] = cooldown_model
+            else:
+                cooldown_model.sync()
+            model = cooldown_model
+        size_model = None
+        if self.target_size:
+            # Every generated tree (including the subtrees created for
+            # mutations) is steered towards the full target size.
+            size_model = self._instances.get(SizeModel)
+            if size_model is None:
+                size_model = SizeModel(model, self.target_size,
+                                       alternation_sizes=getattr(self.generator_cls, '_alternation_sizes', None),
+                                       quantifier_sizes=getattr(self.generator_cls, '_quantifier_sizes', None),
+                                       rng=self.random)
+                self._instances[SizeModel] = size_model
+            model = size_model
+        generator = self.generator_cls(model=model, max_depth=max_depth, flat=self.flat_tree, **self.budgets)
+        if self.profile:
+            # The profiler wraps the other listeners.
+            generator.listeners.append(instantiate(ProfilingListener))
+        if size_model:
+            generator.listeners.append(size_model)
         for listener_cls in self.listener_cls:
             generator.listeners.append(instantiate(listener_cls))
         return Tree(getattr(generator, rule)())
 
+    @property
+    def profiler(self):
+        """
+        ProfilingListener of the current process (created on demand).
+        """
+        profiler = self._instances.get(ProfilingListener)
+        if profiler is None:
+            profiler = self._instances[ProfilingListener] = ProfilingListener()
+        return profiler
+
+    def dump_profile(self, fn):
+        """
+        Write the per-rule statistics collected in the current process (and
+        merged from the workers of a GeneratorPool) to a JSON file and log the
+        most time-consuming rules.
+        """
+        self.profiler.dump(fn)
+        for line in self.profiler.report():
+            logger.info(line)
+
     def random_individuals(self, n):
         return self.population.random_individuals(n=n)
 
     def mutate(self, *args):
-        tree_fn = self.random_individuals(n=1)[0]
-        tree = Tree.load(tree_fn)
+        individual = self.random_individuals(n=1)[0]
+        # Only the new subtree is built and spliced into the tree (if the
+        # format of the population supports it, see LazyTree.splice).
+        tree = self.population.load_lazy(individual)
 
         node = self.random_node(tree)
         if node is None:
             raise ValueError('Could not choose node to mutate.')
 
-        new_tree = self.generate(node.name, self.max_depth - node.level)
-        node.replace(new_tree.root)
-        return tree
+        new_tree = self.generate(tree.name(node), self.max_depth - tree.level(node))
+        return tree.splice(node, new_tree.root)
 
     def recombine(self, *args):
-        tree_1_fn, tree_2_fn = self.random_individuals(n=2)
-        tree_1 = Tree.load(tree_1_fn)
-        tree_2 = Tree.load(tree_2_fn)
+        individual_1 = self.random_individuals(n=1)[0]
+        tree_1 = self.population.load_lazy(individual_1)
+        index = self.population.recombination_index()
 
-        common_types = set(tree_1.node_dict.keys()).intersection(set(tree_2.node_dict.keys()))
-        options = self.default_selector(node for rule_name in common_types for node in tree_1.node_dict[rule_name])
+        options = self.default_selector(tree_1, names=[name for name in tree_1.names() if name in index])
         # Shuffle suitable nodes with sample.
-        tree_1_iter = random.sample(options, k=len(options))
-        for node_1 in tree_1_iter:
-            for node_2 in random.sample(tree_2.node_dict[node_1.name], k=len(tree_2.node_dict[node_1.name])):
-                # Make sure that the output tree won't exceed the depth limit.
-                if node_1.level + node_2.depth <= self.max_depth:
-                    node_1.replace(node_2)
-                    return tree_1
+        for node_1 in random.sample(options, k=len(options)):
+            # Make sure that the output tree won't exceed the depth limit.
+            name, max_depth = tree_1.name(node_1), self.max_depth - tree_1.level(node_1)
+            individual_2 = index.donor(name, max_depth, exclude=individual_1)
+            if individual_2 is None:
+                continue
+
+            # Only the subtree chosen from the donor tree has to be built.
+            tree_2 = self.population.load_lazy(individual_2)
+            nodes_2 = [node for node in tree_2.nodes(name) if tree_2.depth(node) <= max_depth]
+            return tree_1.splice(node_1, tree_2.subtree(random.choice(nodes_2)))
 
         raise ValueError('Could not find node pairs to recombine.')
 
-    def default_selector(self, iterable):
-        def min_depth(node):
-            return getattr(getattr(self.generator_cls, node.name), 'min_depth', 0)
+    def edit(self, *args):
+        """
+        Create a test by a structural edit of an individual of the population
+        that does not need to generate the replaced subtree again: duplicate,
+        delete or swap repetitions of a quantifier, hoist a subtree over its
+        ancestor of the same rule, or replace a lexer rule (token) only. The
+        edits are tried in random order until one of them is applicable.
+        """
+        individual = self.random_individuals(n=1)[0]
+        tree = self.population.load_tree(individual)
+        for edit in random.sample(self.edits, k=len(self.edits)):
+            new_tree = getattr(self, edit)(tree)
+            if new_tree is not None:
+                return new_tree
+        raise ValueError('Could not find nodes to edit.')
+
+    # Names of the edit methods used by edit.
+    edits = ('duplicate_repetition', 'delete_repetition', 'swap_repetitions', 'hoist_subtree', 'replace_token')
+
+    @staticmethod
+    def _sorted_names(names):
+        # Names are sorted (and None, the name of the literal tokens, is
+        # dropped), so that the options built from them do not depend on the
+        # hash seed of the process.
+        return sorted(name for name in names if name is not None)
+
+    def _random_repetition(self, tree, accept):
+        # Choose a quantifier of the tree (matched against the structures of
+        # the rules, see find_repetitions) with an accepted number of
+        # non-empty repetitions.
+        structures = getattr(self.generator_cls, '_rule_structures', {})
+        lazy = LazyTree(tree)
+        options = []
+        for name in self._sorted_names(name for name in tree.node_dict if name in structures):
+            for node in lazy.nodes(name):
+                for repetition in find_repetitions(node, structures[name]):
+                    spans = [span for span in repetition.spans if span[1] > span[0]]
+                    if spans and accept(repetition, len(spans)):
+                        options.append((node, repetition, spans))
+        return random.choice(options) if options else (None, None, None)
+
+    def duplicate_repetition(self, tree):
+        """
+        Duplicate a repetition of a quantifier (inserting the copy after the
+        original), if the quantifier allows more repetitions.
+
+        :return: The modified tree or None if no quantifier is applicable.
+        """
+        node, _, spans = self._random_repetition(tree, lambda repetition, cnt: cnt == len(repetition.spans) and cnt < repetition.max)
+        if node is None:
+            return None
+        start, end = random.choice(spans)
+        copies = [child.deepcopy() for child in node.children[start:end]]
+        for i, child in enumerate(copies):
+            node.insert_child(end + i, child)
+        return tree
+
+    def delete_repetition(self, tree):
+        """
+        Delete a repetition of a quantifier, if the quantifier allows fewer
+        repetitions.
+
+        :return: The modified tree or None if no quantifier is applicable.
+        """
+        node, _, spans = self._random_repetition(tree, lambda repetition, cnt: cnt == len(repetition.spans) and cnt > repetition.min)
+        if node is None:
+            return None
+        start, end = random.choice(spans)
+        for child in node.children[start:end]:
+            child.delete()
+        return tree
+
+    def swap_repetitions(self, tree):
+        """
+        Swap two repetitions of a quantifier.
 
-        return [node for node in iterable if node.name is not None and node.parent is not None and node.name != 'EOF' and node.level + min_depth(node) < self.max_depth]
+        :return: The modified tree or None if no quantifier is applicable.
+        """
+        node, _, spans = self._random_repetition(tree, lambda repetition, cnt: cnt >= 2)
+        if node is None:
+            return None
+        (start_1, end_1), (start_2, end_2) = sorted(random.sample(spans, k=2))
+        children = node.children
+        # The children between the first and the last swapped ones are
+        # reinserted in their new order through the node API.
+        for i, child in enumerate(children[start_2:end_2] + children[end_1:start_2] + children[start_1:end_1]):
+            node.insert_child(start_1 + i, child)
+        return tree
+
+    def hoist_subtree(self, tree):
+        """
+        Replace a subtree with one of its proper subtrees of the same rule
+        (making the tree smaller and shallower).
+
+        :return: The modified (or new) tree or None if no subtree is
+            applicable.
+        """
+        lazy = LazyTree(tree)
+        options = []
+        for name in self._sorted_names(name for name, nodes in tree.node_dict.items() if len(nodes) > 1):
+            for node in lazy.nodes(name):
+                ancestor = node.parent
+                while ancestor is not None and ancestor.name != name:
+                    ancestor = ancestor.parent
+                if ancestor is not None:
+                    options.append((ancestor, node))
+        if not options:
+            return None
+        ancestor, node = random.choice(options)
+        if ancestor.parent is None:
+            # The root cannot be replaced, the subtree becomes the new tree.
+            node.delete()
+            return Tree(node)
+        ancestor.replace(node)
+        return tree
+
+    def replace_token(self, tree):
+        """
+        Replace a node of a lexer rule with a newly generated one. Only the
+        (usually small) subtree of the token is generated.
+
+        :return: The modified tree or None if no token is applicable.
+        """
+        lazy = LazyTree(tree)
+        options = []
+        for name in self._sorted_names(tree.node_dict):
+            rule = getattr(self.generator_cls, name, None)
+            if rule is None or name == 'EOF':
+                continue
+            max_level = self.max_depth - getattr(rule, 'min_depth', 0)
+            options.extend(node for node in lazy.nodes(name) if isinstance(node, UnlexerRule) and 0 < node.level < max_level)
+        if not options:
+            return None
+        node = random.choice(options)
+        root = self.generate(node.name, self.max_depth - node.level).root
+        if isinstance(root, FlatRule):
+            root = root.unflatten()
+        node.replace(root)
+        return tree
+
+    def default_selector(self, tree, names=None):
+        """
+        Select the nodes of a tree that can be replaced with a new subtree.
+
+        :param tree: LazyTree to select the nodes from.
+        :param names: Names of the nodes to consider (default: all names of
+            the tree).
+        :return: List of node handles.
+        """
+        options = []
+        for name in self._sorted_names(names if names is not None else tree.names()):
+            if name == 'EOF':
+                continue
+            max_level = self.max_depth - getattr(getattr(self.generator_cls, name), 'min_depth', 0)
+            options.extend(node for node in tree.nodes(name) if 0 < tree.level(node) < max_level)
+        return options
 
     def random_node(self, tree):
-        options = self.default_selector(x for name in tree.node_dict for x in tree.node_dict[name])
+        options = self.default_selector(tree)
         return random.choice(options) if options else None
 
 
+class GeneratorPool(object):
+    """
+    Long-lived executor of a Generator. With multiple jobs, the worker
+    processes are started once and receive a copy of the generator only at
+    startup, thus the generator (and its model and listener instances) stays
+    warm between the chunks of test indices sent to the workers and between
+    the successive calls to create_tests.
+    """
+
+    def __init__(self, generator, jobs=1, chunk_size=1, report_interval=10.0):
+        """
+        :param generator: Generator object to execute.
+        :param jobs: Number of worker processes (1 to generate in the current
+            process).
+        :param chunk_size: Number of test indices sent to a worker at once.
+        :param report_interval: Seconds between throughput reports (in the
+            log).
+        """
+        self.generator = generator
+        self.jobs = jobs
+        self.chunk_size = max(chunk_size, 1)
+        self.report_interval = report_interval
+        self.pool = None
+        self._profile_dir = None
+        if jobs > 1:
+            if generator.profile:
+                # The workers save their statistics here at exit (see close).
+                self._profile_dir = tempfile.mkdtemp(prefix='grammarinator-profile-')
+            if generator.population:
+                # Read the offsets of the records (and optionally decode the
+                # cached trees) and build the recombination index once, the
+                # workers share them.
+                generator.population.refresh()
+                if generator.population_preload:
+                    generator.population.preload()
+                if generator.enable_recombination:
+                    generator.population.recombination_index()
+            if generator.cooldown < 1:
+                # The workers cool the alternatives down together.
+                generator.cooldown_counts = CooldownCounts(rows=jobs)
+            self.pool = Pool(jobs, initializer=_init_worker, initargs=(generator, self._profile_dir))
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        self.close()
+
+    def close(self):
+        if self.jobs <= 1:
+            self.generator.log_strategy_stats()
+
+        if self.pool:
+            # Let the workers exit normally (and report their statistics).
+            self.pool.close()
+            self.pool.join()
+            self.pool = None
+
+        if self._profile_dir:
+            # Aggregate the statistics of the workers.
+            for fn in glob.glob(join(self._profile_dir, '*.json')):
+                self.generator.profiler.merge(ProfilingListener.load(fn))
+            rmtree(self._profile_dir)
+            self._profile_dir = None
+
+    def create_tests(self, indices):
+        """
+        Generate tests and yield the results of Generator.create_new_test (in
+        the order of completion).
+
+        :param indices: Iterable of test indices.
+        """
+        return self._run(_create_test, self.generator.create_new_test, indices)
+
+    def create_test_data(self, indices):
+        """
+        Generate tests in memory and yield the results of
+        Generator.create_new_test_data (in the order of completion).
+
+        :param indices: Iterable (possibly infinite iterator) of test indices.
+        """
+        return self._run(_create_test_data, self.generator.create_new_test_data, indices)
+
+    def _batches(self, worker_fn, indices):
+        # The pool would consume the whole iterable of indices at once, thus
+        # they are sent in batches that keep all the workers busy.
+        indices = iter(indices)
+        batch_size = self.chunk_size * self.jobs * 4
+        while True:
+            batch = list(islice(indices, batch_size))
+            if not batch:
+                return
+            yield from self.pool.imap_unordered(worker_fn, batch, chunksize=self.chunk_size)
+
+    def _run(self, worker_fn, fn, indices):
+        if self.pool:
+            results = self._batches(worker_fn, indices)
+        else:
+            results = (fn(index) for index in indices)
+
+        cnt, start = 0, time.time()
+        last = start
+        for result in results:
+            cnt += 1
+            yield result
+
+            now = time.time()
+            if now - last >= self.report_interval:
+                last = now
+                logger.info('%d tests generated (%.1f tests/s).', cnt, cnt / (now - start))
+
+        elapsed = time.time() - start
+        logger.info('%d tests generated in %.2fs (%.1f tests/s).', cnt, elapsed, cnt / elapsed if elapsed > 0 else 0.0)
+
+
+_worker_generator = None
+
+
+def _init_worker(generator, profile_dir):
+    global _worker_generator  # pylint: disable=global-statement
+    _worker_generator = generator
+    if generator.cooldown_counts:
+        generator.cooldown_counts.attach()
+    util.Finalize(generator, generator.log_strategy_stats, exitpriority=0)
+    if profile_dir:
+        util.Finalize(generator, _save_worker_profile, args=(generator, profile_dir), exitpriority=0)
+
+
+def _save_worker_profile(generator, profile_dir):
+    if ProfilingListener in generator._instances:
+        generator.profiler.dump(join(profile_dir, '{pid}.json'.format(pid=os.getpid())))
+
+
+def _create_test(index):
+    return _worker_generator.create_new_test(index)
+
+
+def _create_test_data(index):
+    return _worker_generator.create_new_test_data(index)
+
+
+@contextmanager
+def open_stream(target):
+    """
+    Open the binary stream to write the tests into.
+
+    :param target: '-' for the standard output, 'unix:PATH' for a Unix domain
+        socket to connect to, or the path of a file or named pipe.
+    """
+    if target == '-':
+        yield sys.stdout.buffer
+    elif target.startswith('unix:'):
+        with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as sock:
+            sock.connect(target[len('unix:'):])
+            with sock.makefile('wb') as stream:
+                yield stream
+    else:
+        with open(target, 'wb') as stream:
+            yield stream
+
+
+def write_test(stream, data):
+    """
+    Write a length-prefixed test (4-byte, little-endian length followed by the
+    data) to a binary stream.
+    """
+    stream.write(struct.pack('<I', len(data)))
+    stream.write(data)
+    stream.flush()
+
+
 def execute():
     def restricted_float(value):
         value = float(value)
@@ -227,6 +794,10 @@ def execute():
                         help='name of the rule to start generation from (default: first parser rule).')
     parser.add_argument('-m', '--model', metavar='NAME', default='grammarinator.model.DefaultModel',
                         help='reference to the decision model (in package.module.class format) (default: %(default)s).')
+    parser.add_argument('--model-weights', metavar='FILE',
+                        help='file to load the learned weights of the model from and to save them to at exit '
+                             '(for models learning from feedback, e.g., grammarinator.model.FeedbackModel; feedback can only be given '
+                             'through the API, see Generator.feedback; only with --jobs 1).')
     parser.add_argument('-l', '--listener', metavar='NAME', action='append', default=[],
                         help='reference to a listener (in package.module.class format).')
     parser.add_argument('-t', '--transformer', metavar='NAME', action='append', default=[],
@@ -238,59 +809,105 @@ def execute():
                         help='maximum recursion depth during generation (default: %(default)f).')
     parser.add_argument('-c', '--cooldown', default=1.0, type=restricted_float, metavar='NUM',
                         help='cool-down factor defines how much the probability of an alternative should decrease '
-                             'after it has been chosen (interval: (0, 1]; default: %(default)f).')
+                             'after it has been chosen, by any of the --jobs (interval: (0, 1]; default: %(default)f).')
+    parser.add_argument('--target-size', type=int, metavar='NUM',
+                        help='steer quantifiers and alternations towards tests of the given size (number of characters) '
+                             'using the expected sizes computed by the processor.')
+    parser.add_argument('--max-attempts', default=100, type=int, metavar='NUM',
+                        help='maximum number of consecutive failed attempts to create a test before giving up (default: %(default)d).')
+    parser.add_argument('--max-nodes', default=inf, type=int, metavar='NUM',
+                        help='maximum number of nodes of a generated (sub)tree, generations exceeding it are aborted and retried (default: %(default)f).')
+    parser.add_argument('--max-bytes', default=inf, type=int, metavar='NUM',
+                        help='maximum number of characters of a generated (sub)tree, generations exceeding it are aborted and retried (default: %(default)f).')
+    parser.add_argument('--max-time', default=inf, type=float, metavar='SEC',
+                        help='maximum number of seconds to spend on generating a (sub)tree, generations exceeding it are aborted and retried (default: %(default)f).')
+    parser.add_argument('--flat-tree', default=False, action='store_true',
+                        help='build the generated trees into contiguous node arrays instead of separate node objects.')
+    parser.add_argument('--profile', metavar='FILE',
+                        help='collect per-rule statistics (calls, cumulative and self time, output size, level histogram) '
+                             'and write them into a JSON file (the most time-consuming rules are also logged).')
 
     # Evolutionary settings.
     parser.add_argument('--population', metavar='DIR',
-                        help='directory of grammarinator tree pool.')
+                        help='directory of grammarinator tree pool (or population database file with .grdb extension, or subtree store file with .grss extension).')
     parser.add_argument('--no-generate', dest='generate', default=True, action='store_false',
                         help='disable test generation from grammar.')
     parser.add_argument('--no-mutate', dest='mutate', default=True, action='store_false',
                         help='disable test generation by mutation (disabled by default if no population is given).')
     parser.add_argument('--no-recombine', dest='recombine', default=True, action='store_false',
                         help='disable test generation by recombination (disabled by default if no population is given).')
+    parser.add_argument('--no-edit', dest='edit', default=True, action='store_false',
+                        help='disable test generation by structural edits (duplication, deletion and swapping of repeated elements, '
+                             'hoisting of subtrees, replacement of tokens; disabled by default if no population is given).')
     parser.add_argument('--keep-trees', default=False, action='store_true',
                         help='keep generated tests to participate in further mutations or recombinations (default: %(default)d).')
+    parser.add_argument('--population-cache', default=100, type=int, metavar='NUM',
+                        help='number of decoded trees of the population to keep in memory per process (0 disables caching; default: %(default)d).')
+    parser.add_argument('--population-preload', default=False, action='store_true',
+                        help='fill the population cache before the worker processes are started, so that they share its content.')
+    add_tree_format_argument(parser)
 
     # Auxiliary settings.
     parser.add_argument('-o', '--out', metavar='FILE', default=join(os.getcwd(), 'tests', 'test_%d'),
                         help='output file name pattern (default: %(default)s).')
+    parser.add_argument('--stream', metavar='TARGET',
+                        help='write the tests into a stream instead of files, every test prefixed with its length (4-byte, little-endian): '
+                             '\'-\' for the standard output, \'unix:PATH\' for a Unix domain socket, or the path of a file or named pipe.')
     parser.add_argument('--encoding', metavar='ENC', default='utf-8',
                         help='output file encoding (default: %(default)s).')
     parser.add_argument('-n', default=1, type=int, metavar='NUM',
-                        help='number of tests to generate (default: %(default)s).')
+                        help='number of tests to generate (0: until the consumer of --stream closes it; default: %(default)s).')
     parser.add_argument('--random-seed', type=int, metavar='NUM',
-                        help='initialize random number generator with fixed seed (not set by default; noneffective if parallelization is enabled).')
+                        help='master seed of the random number generators: every test is generated with its own seed derived from this '
+                             'and the index of the test, thus the tests do not depend on --jobs (not set by default).')
+    parser.add_argument('--start-index', default=0, type=int, metavar='NUM',
+                        help='index of the first test (e.g., to regenerate a given test of a seeded run alone; default: %(default)d).')
     add_jobs_argument(parser)
+    parser.add_argument('--chunk-size', default=16, type=int, metavar='NUM',
+                        help='number of tests sent to a worker process at once if parallelization is enabled (default: %(default)d).')
     add_sys_path_argument(parser)
     add_sys_recursion_limit_argument(parser)
     add_log_level_argument(parser)
     add_version_argument(parser)
     args = parser.parse_args()
 
-    if args.jobs == 1 and args.random_seed:
-        random.seed(args.random_seed)
-
     process_log_level_argument(args)
     process_sys_path_argument(args)
     process_sys_recursion_limit_argument(args)
+    process_tree_format_argument(args)
 
     if args.population:
-        if not isdir(args.population):
-            parser.error('Population must point to an existing directory.')
+        # Populations that trees are kept in are created if missing.
+        if not isdir(args.population) and not (is_population_file(args.population) and exists(args.population)) and not args.keep_trees:
+            parser.error('Population must point to an existing directory or population database.')
         args.population = abspath(args.population)
 
-    with Generator(generator=args.generator, rule=args.rule, out_format=args.out,
-                   model=args.model, listeners=args.listener, max_depth=args.max_depth, cooldown=args.cooldown,
-                   population=args.population, generate=args.generate, mutate=args.mutate, recombine=args.recombine, keep_trees=args.keep_trees,
-                   transformers=args.transformer, serializer=args.serializer,
-                   cleanup=False, encoding=args.encoding) as generator:
-        if args.jobs > 1:
-            with Pool(args.jobs) as pool:
-                pool.map(generator, range(args.n))
-        else:
-            for i in range(args.n):
-                generator(i)
+    if args.model_weights and args.jobs > 1:
+        # The workers have their own models, which are not saved.
+        parser.error('Model weights can only be saved by a single process (--jobs 1).')
+
+    if args.n <= 0 and not args.stream:
+        parser.error('Unlimited number of tests can only be generated into a stream.')
+
+    with Generator(generator=args.generator, rule=args.rule, out_format=args.out if not args.stream else None,
+                   model=args.model, listeners=args.listener, max_depth=args.max_depth, cooldown=args.cooldown, target_size=args.target_size,
+                   population=args.population, population_cache=args.population_cache, population_preload=args.population_preload, generate=args.generate, mutate=args.mutate, recombine=args.recombine, edit=args.edit, keep_trees=args.keep_trees,
+                   transformers=args.transformer, serializer=args.serializer, flat_tree=args.flat_tree, profile=bool(args.profile), random_seed=args.random_seed, model_weights=args.model_weights,
+                   max_attempts=args.max_attempts, max_nodes=args.max_nodes, max_bytes=args.max_bytes, max_time=args.max_time, cleanup=False, encoding=args.encoding) as generator:
+        with GeneratorPool(generator, jobs=args.jobs, chunk_size=args.chunk_size) as pool:
+            if args.stream:
+                with open_stream(args.stream) as stream:
+                    try:
+                        for data, _ in pool.create_test_data(range(args.start_index, args.start_index + args.n) if args.n > 0 else count(args.start_index)):
+                            write_test(stream, data)
+                    except BrokenPipeError:
+                        logger.info('Stream closed by the consumer.')
+            else:
+                for _ in pool.create_tests(range(args.start_index, args.start_index + args.n)):
+                    pass
+
+        if args.profile:
+            generator.dump_profile(args.profile)
 
 
 if __name__ == '__main__':
@@ -0,0 +1,202 @@
+# Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+#
+# Licensed under the BSD 3-Clause License
+# <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+# This file may not be copied, modified, or distributed except
+# according to those terms.
+
+import os
+import shutil
+
+from argparse import ArgumentParser
+from hashlib import blake2b
+from multiprocessing import Pool
+from os.path import basename, exists, isdir, join, splitext
+
+from .cli import add_jobs_argument, add_log_level_argument, add_tree_format_argument, add_version_argument, logger, process_log_level_argument, process_tree_format_argument
+from .population import is_population_file, open_population, Population, PopulationDB
+from .runtime import Tree, UnlexerRule
+
+
+def subtree_hashes(root):
+    """
+    Compute the structural hashes of the subtrees of a tree: the hash of a
+    node covers its kind (parser or lexer rule), its name, its source (for
+    childless lexer rules) and the hashes of its children, thus structurally
+    identical subtrees get the same hash independently of the tree they are
+    part of.
+
+    :param root: Root of the tree.
+    :return: Tuple of the hash of the root (as an int), the number of nodes,
+        and the set of the hashes of the named proper subtrees (the features
+        of the tree).
+    """
+    # Keyed by the nodes, not by their ids, as the views of flat trees are
+    # recreated at every access (but compare equal).
+    digests = dict()
+    features = set()
+    size = 0
+    stack = [(root, False)]
+    while stack:
+        node, expanded = stack.pop()
+        if node.children and not expanded:
+            stack.append((node, True))
+            stack.extend((child, False) for child in node.children)
+            continue
+
+        h = blake2b(digest_size=8)
+        # The kind distinguishes, e.g., an empty parser rule from a lexer rule
+        # with empty source.
+        h.update(b'\1' if isinstance(node, UnlexerRule) else b'\0')
+        h.update((node.name or '').encode('utf-8', errors='surrogatepass'))
+        h.update(b'\0')
+        if node.children:
+            h.update(b''.join(digests.pop(child) for child in node.children))
+        else:
+            h.update((getattr(node, 'src', None) or '').encode('utf-8', errors='surrogatepass'))
+        digest = h.digest()
+        digests[node] = digest
+        size += 1
+        if node.name is not None and node is not root:
+            features.add(int.from_bytes(digest, 'little'))
+    return int.from_bytes(digests[root], 'little'), size, features
+
+
+# Population of the worker processes (set by _init_worker).
+_population = None
+
+
+def _init_worker(population):
+    global _population  # pylint: disable=global-statement
+    _population = population
+
+
+def _hash_individual(individual):
+    try:
+        return (individual,) + subtree_hashes(_population.load_tree(individual).root)
+    except Exception as e:
+        logger.warning('Exception while loading %s.', individual, exc_info=e)
+        return individual, None, 0, set()
+
+
+def select_individuals(entries, max_size=None, minimize=False):
+    """
+    Select a deduplicated, diverse subset of a population.
+
+    Individuals with identical structural hashes are kept only once (the
+    first one). Then, for every feature (named subtree), the smallest
+    individual containing it is its favorite, and the individuals are ranked
+    by the number of features they are the favorite of (the smaller first if
+    tied). The features of the individuals favored by none are all covered by
+    other, smaller individuals.
+
+    :param entries: Iterable of (individual, root hash, size, features)
+        tuples (see subtree_hashes).
+    :param max_size: Maximum number of individuals to select (None for no
+        limit).
+    :param minimize: Select only the individuals that are favorites of some
+        feature.
+    :return: List of the selected individuals (in the order of their ranks).
+    """
+    unique = dict()
+    for individual, root_hash, size, features in entries:
+        if root_hash is not None and root_hash not in unique:
+            unique[root_hash] = (individual, size, features)
+    candidates = list(unique.values())
+
+    favorites = dict()
+    for i, (_, size, features) in enumerate(candidates):
+        for feature in features:
+            favorite = favorites.get(feature)
+            if favorite is None or candidates[favorite][1] > size:
+                favorites[feature] = i
+
+    scores = [0] * len(candidates)
+    for i in favorites.values():
+        scores[i] += 1
+
+    ranked = sorted(range(len(candidates)), key=lambda i: (-scores[i], candidates[i][1]))
+    if minimize:
+        ranked = [i for i in ranked if scores[i] > 0]
+    if max_size is not None:
+        ranked = ranked[:max_size]
+    logger.info('Selected %d of %d distinct individuals (%d features).', len(ranked), len(candidates), len(favorites))
+    return [candidates[i][0] for i in ranked]
+
+
+def copy_individuals(population, individuals, out):
+    """
+    Copy individuals of a population into a directory, population database
+    or subtree store. Tree files are copied and database records are appended
+    as they are if the formats match, otherwise the trees are re-encoded.
+    """
+    from_db = isinstance(population, PopulationDB)
+    if is_population_file(out):
+        out_db = open_population(out)
+        if from_db and isinstance(out_db, PopulationDB):
+            records = []
+            for individual in individuals:
+                records.append(population.record(individual))
+                if len(records) >= 256:
+                    out_db.add_records(records)
+                    records.clear()
+            if records:
+                out_db.add_records(records)
+        else:
+            for individual in individuals:
+                out_db.add_tree(population.load_tree(individual))
+        return
+
+    os.makedirs(out, exist_ok=True)
+    for individual in individuals:
+        if not isinstance(population, Population):
+            population.load_tree(individual).save(join(out, str(individual) + Tree.extension))
+        elif splitext(individual)[1] == Tree.extension:
+            shutil.copy(individual, out)
+        else:
+            population.load_tree(individual).save(join(out, splitext(basename(individual))[0] + Tree.extension))
+
+
+def execute():
+    parser = ArgumentParser(description='Grammarinator: Minimize',
+                            epilog="""
+                            The tool removes the structurally identical trees of a population and
+                            optionally reduces it to those trees that contribute the most distinct
+                            subtrees, and saves the result as a new population.
+                            """)
+    parser.add_argument('input', metavar='DIR',
+                        help='population directory (or population database file with .grdb extension, or subtree store file with .grss extension) to minimize.')
+    parser.add_argument('-o', '--out', metavar='DIR', required=True,
+                        help='directory (or population database file with .grdb extension, or subtree store file with .grss extension) to save the selected trees to.')
+    parser.add_argument('--max-size', metavar='NUM', type=int,
+                        help='maximum number of trees to keep (the trees contributing the most distinct subtrees are kept).')
+    parser.add_argument('--minimize', default=False, action='store_true',
+                        help='keep only the trees that are the smallest ones containing some distinct subtree '
+                             '(otherwise, only whole-tree duplicates are removed).')
+    add_tree_format_argument(parser)
+    add_jobs_argument(parser)
+    add_log_level_argument(parser)
+    add_version_argument(parser)
+    args = parser.parse_args()
+
+    process_log_level_argument(args)
+    process_tree_format_argument(args)
+
+    if not (isdir(args.input) or (is_population_file(args.input) and exists(args.input))):
+        parser.error('Input must point to an existing population directory or database.')
+    if os.path.abspath(args.input) == os.path.abspath(args.out):
+        parser.error('The output must differ from the input population.')
+
+    population = open_population(args.input)
+    individuals = population.obj_list if isinstance(population, Population) else range(population.size)
+    if args.jobs > 1:
+        with Pool(args.jobs, initializer=_init_worker, initargs=(population,)) as pool:
+            selected = select_individuals(pool.imap(_hash_individual, individuals, chunksize=16), max_size=args.max_size, minimize=args.minimize)
+    else:
+        _init_worker(population)
+        selected = select_individuals(map(_hash_individual, individuals), max_size=args.max_size, minimize=args.minimize)
+    copy_individuals(population, selected, args.out)
+
+
+if __name__ == '__main__':
+    execute()
@@ -5,6 +5,9 @@
 # This file may not be copied, modified, or distributed except
 # according to those terms.
 
-from .cooldown_model import CooldownModel
+from .cooldown_model import CooldownCounts, CooldownModel
+from .cumulative_weights import CumulativeWeights
 from .default_model import DefaultModel
 from .dispatching_model import DispatchingModel
+from .feedback_model import FeedbackModel
+from .size_model import SizeModel
@@ -5,21 +5,159 @@
 # This file may not be copied, modified, or distributed except
 # according to those terms.
 
+import time
+
+from multiprocessing import RawArray, Value
+from zlib import crc32
+
+from .cumulative_weights import CumulativeWeights
+
+
+class CooldownCounts(object):
+    """
+    Counters of the choices of the alternatives shared by the processes of a
+    pool (e.g., the workers of a GeneratorPool), so that the alternatives
+    cool down globally. The counters are stored in shared memory with one row
+    per process, and every process only increments the counters of its own
+    row, thus no locking is needed; the totals are the sums of the rows. The
+    (rule name, alternative index) keys are hashed into a fixed number of
+    slots (colliding keys share their counters).
+
+    The object must be created before the processes are forked, and every
+    process must call attach once before its first update.
+    """
+
+    def __init__(self, rows, slots=1 << 16):
+        self.rows = rows
+        self.slots = slots
+        self._counts = RawArray('L', rows * slots)
+        self._next_row = Value('i', 0)
+        self._offset = 0
+        self._slots = dict()
+
+    def __getstate__(self):
+        state = self.__dict__.copy()
+        state['_slots'] = dict()
+        return state
+
+    def attach(self):
+        """
+        Assign a row to the current process (if there are more processes than
+        rows, the rows are shared and some increments may be lost).
+        """
+        with self._next_row.get_lock():
+            row = self._next_row.value
+            self._next_row.value += 1
+        self._offset = (row % self.rows) * self.slots
+
+    def slot(self, key):
+        slot = self._slots.get(key)
+        if slot is None:
+            slot = self._slots[key] = crc32('{name}\0{idx}'.format(name=key[0], idx=key[1]).encode('utf-8', errors='surrogatepass')) % self.slots
+        return slot
+
+    def increment(self, key):
+        self._counts[self._offset + self.slot(key)] += 1
+
+    def total(self, key):
+        slot, counts = self.slot(key), self._counts
+        return sum(counts[row * self.slots + slot] for row in range(self.rows))
+
 
 class CooldownModel(object):
+    """
+    Model wrapper decreasing the weight of an alternative by the cool-down
+    factor every time it is chosen.
+    """
 
-    def __init__(self, model, weights=None, cooldown=1.0):
+    def __init__(self, model, weights=None, cooldown=1.0, counts=None, sync_interval=0.1):
+        """
+        :param model: The wrapped model.
+        :param weights: Dictionary of the cool-down factors of the
+            alternatives keyed by (rule name, alternative index), updated in
+            place.
+        :param cooldown: Cool-down factor.
+        :param counts: CooldownCounts shared with other processes (None to
+            cool down locally). The choices are counted immediately, but the
+            weights are only updated with the choices of the other processes
+            at sync.
+        :param sync_interval: Minimum time between two synchronizations (in
+            seconds).
+        """
         self._model = model
-        self._weights = weights or dict()
+        self._weights = weights if weights is not None else dict()
         self._cooldown = cooldown
+        self._counts = counts
+        self._sync_interval = sync_interval
+        self._synced = time.monotonic()
+        # Cooled-down copies of static (CumulativeWeights) choices, keyed by
+        # the name of the node and the index of the alternation, and the
+        # number of weight updates of every node name (to detect stale copies).
+        self._tables = dict()
+        self._versions = dict()
 
     def choice(self, node, idx, choices):
-        i = self._model.choice(node, idx, [w * self._weights.get((node.name, i), 1) for i, w in enumerate(choices)])
-        self._weights[(node.name, i)] = self._weights.get((node.name, i), 1) * self._cooldown
+        name = node.name
+        if not isinstance(choices, CumulativeWeights):
+            i = self._model.choice(node, idx, [w * self._weight(name, i) for i, w in enumerate(choices)])
+            self._cool_down(name, i)
+            return i
+
+        # The cooled-down weights are only recomputed if the choices have
+        # changed or if the cool-down factors of the rule have been updated by
+        # another alternation since the last use of this table; the update
+        # caused by the current choice is applied incrementally.
+        key = (name, idx)
+        version = self._versions.get(name, 0)
+        table = self._tables.get(key)
+        if table is None or table[0] is not choices or table[1] != version:
+            table = (choices, version, CumulativeWeights([w * self._weight(name, i) for i, w in enumerate(choices)]))
+
+        i = self._model.choice(node, idx, table[2])
+        weight = self._cool_down(name, i)
+        self._tables[key] = (choices, version + 1, table[2].updated(i, choices[i] * weight))
         return i
 
+    def _weight(self, name, i):
+        weight = self._weights.get((name, i))
+        if weight is None:
+            # Alternatives not seen yet may have been cooled down by other
+            # processes.
+            weight = self._cooldown ** self._counts.total((name, i)) if self._counts else 1
+            self._weights[(name, i)] = weight
+        return weight
+
+    def _cool_down(self, name, i):
+        weight = self._weight(name, i) * self._cooldown
+        self._weights[(name, i)] = weight
+        self._versions[name] = self._versions.get(name, 0) + 1
+        if self._counts:
+            self._counts.increment((name, i))
+        return weight
+
+    def sync(self):
+        """
+        Update the weights with the choices counted by all the processes
+        sharing the counters (if the sync interval has elapsed since the
+        last update).
+        """
+        now = time.monotonic()
+        if not self._counts or now - self._synced < self._sync_interval:
+            return
+        self._synced = now
+        for key, weight in self._weights.items():
+            total = self._cooldown ** self._counts.total(key)
+            if total != weight:
+                self._weights[key] = total
+                self._versions[key[0]] = self._versions.get(key[0], 0) + 1
+
     def quantify(self, node, idx, min, max):
         yield from self._model.quantify(node, idx, min, max)
 
     def charset(self, node, idx, chars):
         return self._model.charset(node, idx, chars)
+
+    def charset_run(self, node, idx, chars, n):
+        if hasattr(self._model, 'charset_run'):
+            return self._model.charset_run(node, idx, chars, n)
+        return ''.join(self._model.charset(node, idx, chars) for _ in range(n))
@@ -0,0 +1,46 @@
+# Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+#
+# Licensed under the BSD 3-Clause License
+# <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+# This file may not be copied, modified, or distributed except
+# according to those terms.
+
+import random
+
+from bisect import bisect_right
+from itertools import accumulate
+
+
+class CumulativeWeights(tuple):
+    """
+    Immutable sequence of choice weights that also stores their running sums,
+    thus a weighted random index can be drawn with a binary search instead of
+    a linear scan. Generators pass such objects to Model.choice when the
+    weights of an alternation are static (precomputed once per alternation
+    and remaining depth), which allows models to cache structures derived
+    from them (keyed by the identity of the object).
+    """
+
+    def __new__(cls, weights):
+        self = super().__new__(cls, weights)
+        self.cum_weights = list(accumulate(self))
+        return self
+
+    def sample(self, rng=random):
+        """
+        Draw a random index with the probability proportional to its weight.
+
+        :param rng: Random number generator to use.
+        """
+        cum_weights = self.cum_weights
+        if not cum_weights[-1]:
+            return 0
+        return bisect_right(cum_weights, rng.random() * cum_weights[-1], 0, len(cum_weights) - 1)
+
+    def updated(self, idx, weight):
+        """
+        Create a copy of the weights with the weight of an index replaced.
+        """
+        weights = list(self)
+        weights[idx] = weight
+        return CumulativeWeights(weights)
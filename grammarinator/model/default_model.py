@@ -7,12 +7,32 @@
 
 import random
 
+from .cumulative_weights import CumulativeWeights
+
 
 class DefaultModel(object):
+    """
+    Model making uniformly random decisions.
+    """
+
+    # Random number generator of the decisions (the global generator of the
+    # random module, unless set by the constructor or by the Generator).
+    random = random
+
+    def __init__(self, *, rng=None):
+        """
+        :param rng: Random number generator to draw the decisions from (e.g.,
+            a random.Random object seeded per test, see Generator); the global
+            generator of the random module by default.
+        """
+        self.random = rng or random
 
     def choice(self, node, idx, choices):
+        if isinstance(choices, CumulativeWeights):
+            return choices.sample(self.random)
+
         # assert sum(choices) > 0, 'Sum of choices is zero.'
-        r = random.uniform(0, sum(choices))
+        r = self.random.uniform(0, sum(choices))
         upto = 0
         for i, w in enumerate(choices):
             if upto + w >= r:
@@ -25,9 +45,26 @@ class DefaultModel(object):
         for _ in range(min):
             yield
             cnt += 1
-        while cnt < max and bool(random.getrandbits(1)):
+        while cnt < max and bool(self.random.getrandbits(1)):
             yield
             cnt += 1
 
     def charset(self, node, idx, chars):
-        return chr(random.choice(chars))
+        return chr(self.random.choice(chars))
+
+    def charset_run(self, node, idx, chars, n):
+        """
+        Draw a run of n characters from a charset at once (e.g., for the
+        quantified charsets of lexer rules).
+
+        :return: String of n characters.
+        """
+        if type(self).charset is not DefaultModel.charset:
+            # Respect the customized choice of single characters.
+            return ''.join(self.charset(node, idx, chars) for _ in range(n))
+        return self._sample_run(chars, n)
+
+    def _sample_run(self, chars, n):
+        if hasattr(chars, 'sample'):
+            return chars.sample(n, self.random)
+        return ''.join(chr(self.random.choice(chars)) for _ in range(n))
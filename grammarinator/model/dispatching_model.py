@@ -5,19 +5,36 @@
 # This file may not be copied, modified, or distributed except
 # according to those terms.
 
+from ..runtime.dispatch import resolve_handler
 from .default_model import DefaultModel
 
 
 class DispatchingModel(DefaultModel):
+    """
+    Model dispatching the decisions about a node to the ``choice_<name>``,
+    ``quantify_<name>``, ``charset_<name>`` and ``charset_run_<name>`` methods
+    if the model defines them for the name of the node. The handlers are
+    resolved once per model class and rule name.
+    """
 
     def choice(self, node, idx, choices):
-        name = 'choice_' + node.name
-        return (getattr(self, name) if hasattr(self, name) else super().choice)(node, idx, choices)
+        fn = resolve_handler(type(self), 'choice_', node.name)
+        return fn(self, node, idx, choices) if fn else super().choice(node, idx, choices)
 
     def quantify(self, node, idx, min, max):
-        name = 'quantify_' + node.name
-        yield from (getattr(self, name) if hasattr(self, name) else super().quantify)(node, idx, min, max)
+        fn = resolve_handler(type(self), 'quantify_', node.name)
+        yield from fn(self, node, idx, min, max) if fn else super().quantify(node, idx, min, max)
 
     def charset(self, node, idx, chars):
-        name = 'charset_' + node.name
-        return (getattr(self, name) if hasattr(self, name) else super().charset)(node, idx, chars)
+        fn = resolve_handler(type(self), 'charset_', node.name)
+        return fn(self, node, idx, chars) if fn else super().charset(node, idx, chars)
+
+    def charset_run(self, node, idx, chars, n):
+        cls = type(self)
+        fn = resolve_handler(cls, 'charset_run_', node.name)
+        if fn:
+            return fn(self, node, idx, chars, n)
+        if resolve_handler(cls, 'charset_', node.name) or cls.charset is not DispatchingModel.charset:
+            # Respect the customized choice of single characters.
+            return ''.join(self.charset(node, idx, chars) for _ in range(n))
+        return self._sample_run(chars, n)
@@ -0,0 +1,143 @@
+# Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+#
+# Licensed under the BSD 3-Clause License
+# <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+# This file may not be copied, modified, or distributed except
+# according to those terms.
+
+import json
+import math
+import os
+
+from .default_model import DefaultModel
+
+
+class FeedbackModel(DefaultModel):
+    """
+    Model learning from the feedback about the generated tests (e.g., whether
+    a test has reached new coverage in the target, see Generator.feedback).
+    The decisions made while generating a test are recorded, and the feedback
+    reinforces (or weakens) them once per decision point: the weights of the
+    alternatives are multiplied by exp(rate * reward * frac), where frac is
+    the fraction of the choices of the alternative in the test, and are then
+    normalized to an average of 1; the probabilities of repeating the
+    quantified expressions move towards (or away from) the average rates
+    observed in the test. Rewarded slow tests count less, unrewarded slow
+    tests count more (relative to the average execution time).
+
+    The learned weights can be saved into and loaded from a JSON file (see
+    save and load) to resume the learning in a later run.
+    """
+
+    def __init__(self, *, rng=None, rate=0.1, penalty=0.1):
+        """
+        :param rng: Random number generator (see DefaultModel).
+        :param rate: Learning rate.
+        :param penalty: Magnitude of the (negative) reward of the tests
+            without new coverage (relative to the reward of 1 of the tests
+            with new coverage).
+        """
+        super().__init__(rng=rng)
+        self.rate = rate
+        self.penalty = penalty
+        # Weights of the alternatives, keyed by (rule name, alternation index).
+        self.weights = dict()
+        # Probabilities of repeating quantified expressions once more (beyond
+        # their minimum), keyed by (rule name, quantifier index).
+        self.repeats = dict()
+        self._choices = []
+        self._quantifiers = []
+        self._time = None
+
+    def begin(self):
+        """
+        Forget the decisions recorded so far (called before a new test).
+        """
+        self._choices.clear()
+        self._quantifiers.clear()
+
+    def choice(self, node, idx, choices):
+        key = (node.name, idx)
+        weights = self.weights.get(key)
+        if weights is not None and len(weights) == len(choices):
+            choices = [w * f for w, f in zip(choices, weights)]
+        i = super().choice(node, idx, choices)
+        self._choices.append((key, i, len(choices)))
+        return i
+
+    def quantify(self, node, idx, min, max):
+        key = (node.name, idx)
+        repeat = self.repeats.get(key, 0.5)
+        cnt = 0
+        while cnt < max and (cnt < min or self.random.random() < repeat):
+            yield
+            cnt += 1
+        self._quantifiers.append((key, cnt - min))
+
+    def feedback(self, new_coverage, exec_time=None):
+        """
+        Update the weights with the feedback about the test generated last.
+
+        :param new_coverage: Whether the test has reached new coverage.
+        :param exec_time: Execution time of the test (optional).
+        """
+        reward = 1.0 if new_coverage else -self.penalty
+        if exec_time is not None:
+            if self._time is None:
+                self._time = exec_time
+            slowdown = exec_time / self._time if self._time > 0 else 1.0
+            self._time += 0.05 * (exec_time - self._time)
+            if slowdown > 1:
+                reward = reward / slowdown if reward > 0 else reward * min(slowdown, 10)
+
+        # Frequencies of the alternatives per decision point.
+        chosen = dict()
+        for key, i, cnt in self._choices:
+            freqs = chosen.get(key)
+            if freqs is None or len(freqs) != cnt:
+                freqs = chosen[key] = [0] * cnt
+            freqs[i] += 1
+        for key, freqs in chosen.items():
+            weights = self.weights.get(key)
+            if weights is None or len(weights) != len(freqs):
+                weights = [1.0] * len(freqs)
+            total = sum(freqs)
+            weights = [w * math.exp(self.rate * reward * freq / total) for w, freq in zip(weights, freqs)]
+            norm = len(weights) / sum(weights)
+            self.weights[key] = [min(max(w * norm, 1e-3), 1e3) for w in weights]
+
+        # Extra repetitions per quantifier.
+        repeated = dict()
+        for key, cnt in self._quantifiers:
+            repeated.setdefault(key, []).append(cnt)
+        for key, cnts in repeated.items():
+            repeat = self.repeats.get(key, 0.5)
+            # The rate of repetition that produces the observed number of
+            # extra repetitions on average.
+            mean = sum(cnts) / len(cnts)
+            observed = mean / (mean + 1)
+            self.repeats[key] = min(max(repeat + self.rate * reward * (observed - repeat), 0.05), 0.95)
+        self.begin()
+
+    def save(self, fn):
+        """
+        Save the learned weights into a JSON file.
+        """
+        data = {'choice': {}, 'quantify': {}}
+        for (name, idx), weights in self.weights.items():
+            data['choice'].setdefault(name, {})[str(idx)] = [round(w, 6) for w in weights]
+        for (name, idx), repeat in self.repeats.items():
+            data['quantify'].setdefault(name, {})[str(idx)] = round(repeat, 6)
+        tmp_fn = '{fn}.{pid}.tmp'.format(fn=fn, pid=os.getpid())
+        with open(tmp_fn, 'w') as f:
+            json.dump(data, f, separators=(',', ':'), sort_keys=True)
+        os.replace(tmp_fn, fn)
+
+    def load(self, fn):
+        """
+        Load the weights saved by save.
+        """
+        with open(fn, 'r') as f:
+            data = json.load(f)
+        self.weights = {(name, int(idx)): weights for name, items in data.get('choice', {}).items() for idx, weights in items.items()}
+        self.repeats = {(name, int(idx)): repeat for name, items in data.get('quantify', {}).items() for idx, repeat in items.items()}
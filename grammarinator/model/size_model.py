@@ -0,0 +1,111 @@
+# Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+#
+# Licensed under the BSD 3-Clause License
+# <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+# This file may not be copied, modified, or distributed except
+# according to those terms.
+
+import random
+
+
+class SizeModel(object):
+    """
+    Model wrapper steering the generation towards a target size (number of
+    characters) using the expected sizes of the alternatives and of the
+    quantified expressions computed by the processor (the
+    ``_alternation_sizes`` and ``_quantifier_sizes`` tables of the generated
+    fuzzers). Alternatives expected to overshoot the remaining budget are
+    down-weighted proportionally, and quantifiers repeat with a probability
+    that decreases as the budget gets used up.
+
+    The wrapper must also be registered as a listener of the generator, as
+    the size of the output so far is accumulated at the exits of the rules.
+    (Tokens of the rule being generated are only counted when the rule exits,
+    thus the repetitions of a quantifier are also charged with their expected
+    size while it is in progress.)
+    """
+
+    def __init__(self, model, target, alternation_sizes=None, quantifier_sizes=None, rng=None):
+        """
+        :param model: The wrapped model.
+        :param target: Target size of the generated tests.
+        :param alternation_sizes: Lists of the expected sizes of the
+            alternatives, keyed by rule name and alternation index.
+        :param quantifier_sizes: Expected sizes of one repetition, keyed by
+            rule name and quantifier index.
+        :param rng: Random number generator (the global generator of the
+            random module by default).
+        """
+        self._model = model
+        self.target = target
+        self._alternation_sizes = alternation_sizes or dict()
+        self._quantifier_sizes = quantifier_sizes or dict()
+        self.random = rng or random
+        self.size = 0
+
+    def enter_rule(self, node):
+        if node.parent is None:
+            self.size = 0
+
+    def exit_rule(self, node):
+        for child in node.children:
+            if child.name is None:
+                self.size += len(getattr(child, 'src', None) or '')
+        if not node.children:
+            self.size += len(getattr(node, 'src', None) or '')
+
+    def choice(self, node, idx, choices):
+        sizes = self._alternation_sizes.get((node.name, idx))
+        remaining = max(self.target - self.size, 1)
+        if sizes is None or all(size <= remaining for size in sizes):
+            # Keep the original (possibly static) weights if nothing has to
+            # be steered.
+            return self._model.choice(node, idx, choices)
+
+        weights = [w * remaining / size if size > remaining else w for w, size in zip(choices, sizes)]
+        if not any(weights):
+            # Every enabled alternative overshoots infinitely: fall back to
+            # the smallest ones.
+            smallest = min((size for w, size in zip(choices, sizes) if w > 0), default=None)
+            if smallest is None:
+                return self._model.choice(node, idx, choices)
+            weights = [w if size == smallest else 0 for w, size in zip(choices, sizes)]
+        return self._model.choice(node, idx, weights)
+
+    def quantify(self, node, idx, min, max):
+        size = self._quantifier_sizes.get((node.name, idx))
+        if size is None:
+            yield from self._model.quantify(node, idx, min, max)
+            return
+
+        # Repetitions beyond the minimum stop with the probability of
+        # (size / (remaining + size)) ** 2, i.e., ~0 while the budget is large
+        # compared to the quantified expression, and 1 when it has run out
+        # (thus long runs get close to the target instead of stopping
+        # uniformly anywhere below it). The remaining budget is the smaller of
+        # the estimates based on the size counted so far (which only grows at
+        # the exits of the subrules) and on the expected size of the
+        # repetitions yielded so far (which may not be counted yet, e.g., the
+        # characters of a charset consumed in one go by the template). (The
+        # parameters shadow the min and max builtins.)
+        size = size if size < self.target else self.target
+        size = size if size > 1 else 1
+        budget = self.target - self.size
+        cnt = 0
+        while cnt < max:
+            if cnt >= min:
+                remaining = self.target - self.size
+                remaining = remaining if remaining < budget else budget
+                if remaining <= 0 or self.random.random() < (size / (remaining + size)) ** 2:
+                    break
+            yield
+            budget -= size
+            cnt += 1
+
+    def charset(self, node, idx, chars):
+        return self._model.charset(node, idx, chars)
+
+    def charset_run(self, node, idx, chars, n):
+        if hasattr(self._model, 'charset_run'):
+            return self._model.charset_run(node, idx, chars, n)
+        return ''.join(self._model.charset(node, idx, chars) for _ in range(n))
@@ -13,13 +13,14 @@ import shutil
 from argparse import ArgumentParser
 from math import inf
 from multiprocessing import Pool
-from os.path import basename, exists, join
+from os.path import abspath, basename, dirname, exists, getsize, isdir, join
 
 from antlr4 import CommonTokenStream, error, FileStream, ParserRuleContext, TerminalNode, Token
 
-from .cli import add_antlr_argument, add_disable_cleanup_argument, add_jobs_argument, add_log_level_argument, add_sys_path_argument, add_sys_recursion_limit_argument, add_version_argument, logger, process_antlr_argument, process_log_level_argument, process_sys_path_argument, process_sys_recursion_limit_argument
+from .cli import add_antlr_argument, add_disable_cleanup_argument, add_jobs_argument, add_log_level_argument, add_sys_path_argument, add_sys_recursion_limit_argument, add_tree_format_argument, add_version_argument, logger, process_antlr_argument, process_log_level_argument, process_sys_path_argument, process_sys_recursion_limit_argument, process_tree_format_argument
 from .parser_builder import build_grammars
 from .pkgdata import default_antlr_path
+from .population import is_population_file, open_population, PopulationDB
 from .runtime import Tree, UnlexerRule, UnparserRule
 
 
@@ -50,6 +51,7 @@ class ParserFactory(object):
         transformers = transformers if isinstance(transformers, list) else json.loads(transformers) if transformers else []
         self.transformers = [import_entity(transformer) if isinstance(transformer, str) else transformer for transformer in transformers]
         self.hidden = hidden if isinstance(hidden, list) else json.loads(hidden) if hidden else []
+        self.tree_extension = Tree.extension
 
         self.parser_dir = parser_dir
         os.makedirs(self.parser_dir, exist_ok=True)
@@ -68,49 +70,87 @@ class ParserFactory(object):
         if self.cleanup:
             shutil.rmtree(self.parser_dir, ignore_errors=True)
 
-    def antlr_to_grammarinator_tree(self, antlr_node, parser, visited=None):
-        if visited is None:
-            visited = set()
-
-        if isinstance(antlr_node, ParserRuleContext):
-            rule_name = parser.ruleNames[antlr_node.getRuleIndex()]
-            class_name = antlr_node.__class__.__name__
-
-            # Check if the rule is a labeled alternative.
-            if not class_name.lower().startswith(rule_name.lower()):
-                alt_name = class_name[:-len('Context')] if class_name.endswith('Context') else class_name
-                rule_name = '{rule_name}_{alternative}'.format(
-                    rule_name=rule_name,
-                    alternative=alt_name[0].upper() + alt_name[1:])
-
-            node = UnparserRule(name=rule_name)
-            assert node.name, 'Node name of a parser rule is empty or None.'
-            for child in (antlr_node.children or []):
-                node += self.antlr_to_grammarinator_tree(child, parser, visited)
-        else:
+    @staticmethod
+    def _rule_name(antlr_node, rule_names):
+        rule_name = rule_names[antlr_node.getRuleIndex()]
+        class_name = antlr_node.__class__.__name__
+
+        # Check if the rule is a labeled alternative.
+        if not class_name.lower().startswith(rule_name.lower()):
+            alt_name = class_name[:-len('Context')] if class_name.endswith('Context') else class_name
+            rule_name = '{rule_name}_{alternative}'.format(
+                rule_name=rule_name,
+                alternative=alt_name[0].upper() + alt_name[1:])
+        return rule_name
+
+    def antlr_to_grammarinator_tree(self, antlr_node, parser):
+        """
+        Convert an ANTLR parse tree into a Grammarinator tree. The tree is
+        built top-down without recursion (thus, every node is attached as a
+        leaf and the depth of the tree is not limited by the Python stack).
+        The hidden tokens are attached in a single pass over the token stream:
+        the terminals are visited in the order of their tokens, and the hidden
+        tokens following a terminal (up to the next on-channel token) are
+        added right after it, the ones preceding the first terminal right
+        before it.
+
+        :param antlr_node: Root of the ANTLR parse tree.
+        :param parser: The parser that built the parse tree.
+        :return: Root of the Grammarinator tree (or, if the root is a terminal
+            and hidden tokens are kept, the list of the resulting nodes).
+        """
+        rule_names, symbolic_names = parser.ruleNames, parser.symbolicNames
+        rule_name_cache = dict()
+        if self.hidden:
+            stream = parser.getTokenStream()
+            stream.fill()
+            tokens = stream.tokens
+            hidden_types = {token_type for token_type, name in enumerate(symbolic_names) if name in self.hidden}
+            # Index of the first token whose hidden tokens are not attached yet.
+            cursor = 0
+
+        def hidden_nodes(start, end):
+            return [UnlexerRule(name=symbolic_names[token.type], src=token.text) for token in tokens[start:end]
+                    if token.channel != Token.DEFAULT_CHANNEL and token.type in hidden_types]
+
+        root = None
+        stack = [(antlr_node, None)]
+        while stack:
+            antlr_node, parent = stack.pop()
+            if isinstance(antlr_node, ParserRuleContext):
+                key = (antlr_node.__class__, antlr_node.getRuleIndex())
+                rule_name = rule_name_cache.get(key)
+                if rule_name is None:
+                    rule_name = rule_name_cache[key] = self._rule_name(antlr_node, rule_names)
+                node = UnparserRule(name=rule_name, parent=parent)
+                assert node.name, 'Node name of a parser rule is empty or None.'
+                if parent is None:
+                    root = node
+                stack.extend((child, node) for child in reversed(antlr_node.children or []))
+                continue
+
             assert isinstance(antlr_node, TerminalNode), 'An ANTLR node must either be a ParserRuleContext or a TerminalNode but {node_cls} was found.'.format(node_cls=antlr_node.__class__.__name__)
-            name, text = (parser.symbolicNames[antlr_node.symbol.type], antlr_node.symbol.text) if antlr_node.symbol.type != Token.EOF else ('EOF', '')
+            symbol = antlr_node.symbol
+            name, text = (symbolic_names[symbol.type], symbol.text) if symbol.type != Token.EOF else ('EOF', '')
             assert name, '{name} is None or empty'.format(name=name)
 
             if not self.hidden:
-                node = UnlexerRule(name=name, src=text)
+                node = UnlexerRule(name=name, src=text, parent=parent)
+                if parent is None:
+                    root = node
+                continue
+
+            index = symbol.tokenIndex
+            end = index + 1
+            while end < len(tokens) and tokens[end].channel != Token.DEFAULT_CHANNEL:
+                end += 1
+            nodes = hidden_nodes(cursor, index) + [UnlexerRule(name=name, src=text)] + hidden_nodes(index + 1, end)
+            cursor = max(cursor, end)
+            if parent is None:
+                root = nodes
             else:
-                hidden_tokens_to_left = parser.getTokenStream().getHiddenTokensToLeft(antlr_node.symbol.tokenIndex, -1) or []
-                node = []
-                for token in hidden_tokens_to_left:
-                    if parser.symbolicNames[token.type] in self.hidden:
-                        if token not in visited:
-                            node.append(UnlexerRule(name=parser.symbolicNames[token.type], src=token.text))
-                            visited.add(token)
-
-                node.append(UnlexerRule(name=name, src=text))
-                hidden_tokens_to_right = parser.getTokenStream().getHiddenTokensToRight(antlr_node.symbol.tokenIndex, -1) or []
-                for token in hidden_tokens_to_right:
-                    if parser.symbolicNames[token.type] in self.hidden:
-                        if token not in visited:
-                            node.append(UnlexerRule(name=parser.symbolicNames[token.type], src=token.text))
-                            visited.add(token)
-        return node
+                parent.add_children(nodes)
+        return root
 
     def create_tree(self, input_stream, rule, fn=None):
         try:
@@ -131,18 +171,146 @@ class ParserFactory(object):
         return None
 
     def tree_from_file(self, fn, rule, out, encoding):
+        """
+        Parse a file and save its tree into the output directory or append it
+        to the output population database (or subtree store).
+
+        :return: True if the tree was saved.
+        """
+        if is_population_file(out):
+            record = self.record_from_file(fn, rule, encoding)
+            if record is not None:
+                add_records(open_population(out), [record])
+            return record is not None
+
+        logger.info('Process file %s.', fn)
+        try:
+            tree = self.create_tree(FileStream(fn, encoding=encoding), rule, fn)
+            if tree is not None and tree.depth <= self.max_depth:
+                tree.save(join(out, basename(fn) + self.tree_extension))
+                return True
+        except Exception as e:
+            logger.warning('Exception while processing %s.', fn, exc_info=e)
+        return False
+
+    def record_from_file(self, fn, rule, encoding):
+        """
+        Parse a file and encode its tree as a record of a population database
+        (without writing it, so that the records of parallel workers can be
+        appended by a single process).
+
+        :return: The encoded tree, or None if the file could not be parsed or
+            its tree is deeper than the limit.
+        """
         logger.info('Process file %s.', fn)
         try:
             tree = self.create_tree(FileStream(fn, encoding=encoding), rule, fn)
-            if tree is not None:
-                tree.save(join(out, basename(fn) + Tree.extension), max_depth=self.max_depth)
+            if tree is not None and tree.depth <= self.max_depth:
+                return PopulationDB.codec.encode(tree)
         except Exception as e:
             logger.warning('Exception while processing %s.', fn, exc_info=e)
+        return None
+
+
+def add_records(population, records):
+    """
+    Add encoded trees (see ParserFactory.record_from_file) to a population
+    database or subtree store.
+    """
+    if isinstance(population, PopulationDB):
+        population.add_records(records)
+    else:
+        for record in records:
+            population.add_tree(PopulationDB.codec.decode(record))
+
 
+def iterate_inputs(inputs):
+    """
+    Collect the input files (walking the directories recursively), the
+    largest ones first: as the workers take the next file when they become
+    idle, the long-running parses are started early and do not keep the pool
+    waiting at the end.
+    """
+    files = []
+    for path in inputs:
+        if isdir(path):
+            for root, _, fns in os.walk(path):
+                files.extend(join(root, fn) for fn in fns)
+        else:
+            files.append(path)
+
+    def size(fn):
+        try:
+            return getsize(fn)
+        except OSError:
+            return 0
+
+    files.sort(key=size, reverse=True)
+    return files
+
+
+# Arguments of the worker processes (set by _init_worker), so that the factory
+# is not pickled for every input file.
+_worker_args = None
 
-def iterate_tests(files, rule, out, encoding):
-    for test in files:
-        yield (test, rule, out, encoding)
+
+def _init_worker(factory, rule, out, encoding):
+    global _worker_args  # pylint: disable=global-statement
+    _worker_args = (factory, rule, out, encoding)
+
+
+def _process_file(fn):
+    factory, rule, out, encoding = _worker_args
+    if is_population_file(out):
+        return factory.record_from_file(fn, rule, encoding)
+    return factory.tree_from_file(fn, rule, out, encoding)
+
+
+def ingest(factory, files, rule, out, encoding, jobs=1, batch_size=256):
+    """
+    Parse the input files and save their trees into the output directory or
+    population database. With multiple jobs, the files are handed out to the
+    worker processes one by one as they become idle, and the records of a
+    population database are appended in batches by the calling process.
+
+    :param factory: The ParserFactory to parse the files with.
+    :param files: List of input files (see iterate_inputs).
+    :param rule: Name of the rule to start parsing with.
+    :param out: Output directory, population database or subtree store file.
+    :param encoding: Encoding of the input files.
+    :param jobs: Number of worker processes.
+    :param batch_size: Number of records to append to a population database
+        at once.
+    :return: Number of the saved trees.
+    """
+    population = open_population(out) if is_population_file(out) else None
+    saved, batch = 0, []
+
+    def collect(results):
+        nonlocal saved
+        for result in results:
+            if population is None:
+                saved += bool(result)
+                continue
+            if result is not None:
+                batch.append(result)
+            if len(batch) >= batch_size:
+                add_records(population, batch)
+                saved += len(batch)
+                batch.clear()
+
+    if jobs > 1:
+        with Pool(jobs, initializer=_init_worker, initargs=(factory, rule, out, encoding)) as pool:
+            collect(pool.imap_unordered(_process_file, files, chunksize=1))
+    else:
+        _init_worker(factory, rule, out, encoding)
+        collect(map(_process_file, files))
+
+    if batch:
+        add_records(population, batch)
+        saved += len(batch)
+    logger.info('Saved %d trees from %d files.', saved, len(files))
+    return saved
 
 
 def execute():
@@ -155,7 +323,7 @@ def execute():
     parser.add_argument('grammar', metavar='FILE', nargs='+',
                         help='ANTLR grammar files describing the expected format of input to parse.')
     parser.add_argument('-i', '--input', metavar='FILE', nargs='+', required=True,
-                        help='input files to process.')
+                        help='input files (or directories of input files) to process.')
     parser.add_argument('-r', '--rule', metavar='NAME',
                         help='name of the rule to start parsing with (default: first parser rule).')
     parser.add_argument('-t', '--transformer', metavar='NAME', action='append', default=[],
@@ -167,9 +335,10 @@ def execute():
     parser.add_argument('--max-depth', type=int, default=inf,
                         help='maximum expected tree depth (deeper tests will be discarded (default: %(default)f)).')
     parser.add_argument('-o', '--out', metavar='DIR', default=os.getcwd(),
-                        help='directory to save the trees (default: %(default)s).')
+                        help='directory (or population database file with .grdb extension, or subtree store file with .grss extension) to save the trees (default: %(default)s).')
     parser.add_argument('--parser-dir', metavar='DIR',
-                        help='directory to save the parser grammars (default: <OUTDIR>/grammars).')
+                        help='directory to save the parser grammars (default: <OUTDIR>/grammars, or grammars next to the population database).')
+    add_tree_format_argument(parser)
     add_disable_cleanup_argument(parser)
     add_jobs_argument(parser)
     add_antlr_argument(parser)
@@ -184,21 +353,17 @@ def execute():
             parser.error('{grammar} does not exist.'.format(grammar=grammar))
 
     if not args.parser_dir:
-        args.parser_dir = join(args.out, 'grammars')
+        args.parser_dir = join(dirname(abspath(args.out)) if is_population_file(args.out) else args.out, 'grammars')
 
     process_log_level_argument(args)
     process_sys_path_argument(args)
     process_sys_recursion_limit_argument(args)
+    process_tree_format_argument(args)
     process_antlr_argument(args)
 
     with ParserFactory(grammars=args.grammar, hidden=args.hidden, transformers=args.transformer, parser_dir=args.parser_dir, antlr=args.antlr,
                        max_depth=args.max_depth, cleanup=args.cleanup) as factory:
-        if args.jobs > 1:
-            with Pool(args.jobs) as pool:
-                pool.starmap(factory.tree_from_file, iterate_tests(args.input, args.rule, args.out, args.encoding))
-        else:
-            for create_args in iterate_tests(args.input, args.rule, args.out, args.encoding):
-                factory.tree_from_file(*create_args)
+        ingest(factory, iterate_inputs(args.input), args.rule, args.out, args.encoding, jobs=args.jobs)
 
 
 if __name__ == '__main__':
@@ -0,0 +1,872 @@
+# Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+#
+# Licensed under the BSD 3-Clause License
+# <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+# This file may not be copied, modified, or distributed except
+# according to those terms.
+
+import glob
+import json
+import mmap
+import os
+import random
+import struct
+import tempfile
+
+from array import array
+from bisect import bisect_right, insort
+from collections import OrderedDict
+from hashlib import blake2b
+from math import inf
+from multiprocessing import util
+from os.path import abspath, basename, dirname, join
+
+from .cli import logger
+from .runtime import BinaryTreeCodec, EncodedLazyTree, Tree, UnlexerRule
+from .runtime.tree_codec import ChunkWriter, read_varint, write_varint
+
+
+class TreeCache(object):
+    """
+    LRU cache of decoded individuals (LazyTree objects) of a population. Only
+    reusable objects are cached, i.e., those that materialize new nodes at
+    every request, thus the cached entries are never modified by mutations.
+
+    There is one cache per population and process (see instance), so the
+    entries loaded before the worker processes are forked are shared by the
+    workers (copy-on-write), and the entries loaded by a worker are reused by
+    all the subsequent tests generated by that worker. The hit and miss
+    counters of every process are logged when the process exits.
+    """
+
+    _instances = dict()
+
+    def __init__(self, size):
+        self.size = size
+        self.hits = 0
+        self.misses = 0
+        self._items = OrderedDict()
+        self._pid = None
+
+    @staticmethod
+    def instance(key, size):
+        """
+        Get the cache of a population in the current process.
+
+        :param key: Identifier of the population (e.g., its path).
+        :param size: Maximum number of cached individuals.
+        """
+        cache = TreeCache._instances.get(key)
+        if cache is None:
+            cache = TreeCache(size)
+            TreeCache._instances[key] = cache
+        if cache._pid != os.getpid():
+            # New process (or a forked copy of the cache): count its own
+            # statistics and report them at exit.
+            cache._pid = os.getpid()
+            cache.hits = cache.misses = 0
+            util.Finalize(cache, cache.log_stats, args=(key, ), exitpriority=0)
+        return cache
+
+    def __len__(self):
+        return len(self._items)
+
+    def __contains__(self, key):
+        return key in self._items
+
+    def get(self, key, load):
+        """
+        Get a cached individual or load (and cache) it.
+
+        :param key: Reference to the individual.
+        :param load: Function to load the individual if it is not cached.
+        """
+        item = self._items.get(key)
+        if item is not None:
+            self._items.move_to_end(key)
+            self.hits += 1
+            return item
+
+        self.misses += 1
+        item = load(key)
+        self.put(key, item)
+        return item
+
+    def put(self, key, item):
+        if not item.reusable or self.size <= 0:
+            return
+        self._items[key] = item
+        self._items.move_to_end(key)
+        while len(self._items) > self.size:
+            self._items.popitem(last=False)
+
+    def log_stats(self, key):
+        if self.hits or self.misses:
+            logger.info('Population cache of %s (pid %d): %d hits, %d misses, %d cached.', key, os.getpid(), self.hits, self.misses, len(self._items))
+
+
+class RecombinationIndex(object):
+    """
+    Population-wide index of the rule names occurring in the individuals.
+    For every name, it holds the individuals containing a node of that name,
+    sorted by the depth of the shallowest such node. Thus, the donors that can
+    provide a subtree of a given name within a depth limit form a prefix of
+    the entries, and a donor can be chosen with a binary search instead of
+    loading and scanning trees.
+
+    The index is updated incrementally: individuals are indexed when they are
+    added to the population, or when they are first seen (e.g., the existing
+    individuals at first use, or the records appended by other processes).
+    The name depths of the indexed individuals are also appended to a file
+    next to the population (as JSON lines of the keys of the individuals, see
+    the index_key methods of the populations, and their name depths), thus
+    later runs only have to decode the individuals added since. The keys
+    identify the contents of the individuals, so the entries of replaced or
+    rewritten individuals are not reused.
+    """
+
+    def __init__(self, fn=None):
+        """
+        :param fn: File of the saved name depths (None to not save them).
+        """
+        # Per name: list of (depth, serial, individual) entries, where serial
+        # breaks ties between individuals (which may not be comparable).
+        self._entries = dict()
+        self._serial = 0
+        # Number of the individuals of the population already indexed.
+        self.indexed = 0
+        self.fn = fn
+        # Saved name depths not used yet, keyed by individual keys, and the
+        # position in the file read so far.
+        self._saved = dict()
+        self._saved_end = 0
+
+    def __contains__(self, name):
+        return name in self._entries
+
+    def add(self, individual, depths):
+        """
+        Index an individual.
+
+        :param individual: Reference to the individual.
+        :param depths: Dictionary of the minimum subtree depth of every name
+            in the individual.
+        """
+        for name, depth in depths.items():
+            if name is None:
+                continue
+            if name not in self._entries:
+                self._entries[name] = []
+            insort(self._entries[name], (depth, self._serial, individual))
+            self._serial += 1
+
+    def donors(self, name, max_depth):
+        """
+        :return: Number of the individuals that contain a subtree of the given
+            name not deeper than max_depth (see donor).
+        """
+        entries = self._entries.get(name)
+        return bisect_right(entries, (max_depth, inf)) if entries else 0
+
+    def donor(self, name, max_depth, exclude=None):
+        """
+        Choose a random individual that contains a subtree of the given name
+        not deeper than max_depth.
+
+        :param exclude: Individual to avoid choosing (unless it is the only
+            option).
+        :return: Reference to the individual (None if there is none).
+        """
+        cnt = self.donors(name, max_depth)
+        if not cnt:
+            return None
+        entries = self._entries[name]
+        individual = entries[random.randrange(cnt)][2]
+        if individual == exclude and cnt > 1:
+            # Choose among the others (shifting the indices after the excluded
+            # entry).
+            pos = next(i for i in range(cnt) if entries[i][2] == exclude)
+            choice = random.randrange(cnt - 1)
+            individual = entries[choice + (choice >= pos)][2]
+        return individual
+
+    @staticmethod
+    def name_depths(tree):
+        """
+        Compute the minimum subtree depth of every name of a (Lazy)Tree.
+        """
+        encoded = getattr(tree, 'encoded', None)
+        if encoded is not None:
+            # Do not build the nodes of encoded trees (see EncodedTree).
+            names, _, columns, index = encoded
+            depths = columns['depth']
+            return dict((names[name_id], min(depths[i] for i in column)) for name_id, column in index.items())
+        if isinstance(tree, Tree):
+            tree.ensure_annotated()
+            return dict((name, min(node.depth for node in nodes)) for name, nodes in tree.node_dict.items())
+        return dict((name, min(tree.depth(node) for node in tree.nodes(name))) for name in tree.names())
+
+    def update(self, population, individuals):
+        """
+        Index the individuals of a population not indexed yet, reusing their
+        saved name depths if available.
+
+        :param individuals: Sequence of all the individuals of the population
+            (in the order they were added).
+        """
+        individuals = individuals[self.indexed:]
+        if not individuals:
+            return
+
+        self._read()
+        unsaved = []
+        for individual in individuals:
+            try:
+                key = population.index_key(individual)
+                depths = self._saved.pop(key, None)
+                if depths is None:
+                    depths = self.name_depths(population._load_lazy(individual))
+                    unsaved.append((key, depths))
+                self.add(individual, depths)
+            except Exception as e:
+                logger.warning('Failed to index %s for recombination.', individual, exc_info=e)
+            self.indexed += 1
+        self.save(unsaved)
+
+    def _read(self):
+        # Read the entries appended to the file since the last read. An
+        # incomplete last line (of a writer still writing) is read later.
+        if not self.fn:
+            return
+        try:
+            with open(self.fn, 'rb') as f:
+                f.seek(self._saved_end)
+                data = f.read()
+        except FileNotFoundError:
+            return
+        end = data.rfind(b'\n') + 1
+        for line in data[:end].splitlines():
+            try:
+                key, depths = json.loads(line.decode('utf-8'))
+                self._saved[tuple(key)] = dict(depths)
+            except ValueError:
+                # Lines corrupted by a crashed writer are skipped, their
+                # individuals are decoded again.
+                continue
+        self._saved_end += end
+
+    def save(self, entries):
+        """
+        Append name depths to the file of the index (with a single write call,
+        so that processes sharing the file can save concurrently).
+
+        :param entries: List of (key, depths) pairs of individuals.
+        """
+        if not self.fn or not entries:
+            return
+        data = memoryview(''.join(json.dumps([key, sorted((name, depth) for name, depth in depths.items() if name is not None)]) + '\n' for key, depths in entries).encode('utf-8'))
+        try:
+            with open(self.fn, 'ab', buffering=0) as f:
+                while data:
+                    data = data[f.write(data):]
+        except OSError as e:
+            logger.debug('Failed to save the recombination index to %s.', self.fn, exc_info=e)
+
+
+class Population(object):
+    """
+    Population of trees saved into separate files of a directory. Individuals
+    are referred to by the names of their files.
+    """
+
+    def __init__(self, directory, cache_size=0):
+        self.directory = directory
+        self.tree_extension = Tree.extension
+        self.cache_size = cache_size
+        os.makedirs(directory, exist_ok=True)
+        self.obj_list = [fn for ext in Tree.codecs for fn in glob.glob(join(self.directory, '*' + ext))]
+        self._recombination_index = RecombinationIndex(join(directory, '.recombination-index'))
+
+    def recombination_index(self):
+        """
+        Get the RecombinationIndex of the population, updated with the
+        individuals not indexed yet.
+        """
+        self._recombination_index.update(self, self.obj_list)
+        return self._recombination_index
+
+    @property
+    def cache(self):
+        return TreeCache.instance(self.directory, self.cache_size) if self.cache_size > 0 else None
+
+    def random_individuals(self, n=1):
+        return random.sample(self.obj_list, n)
+
+    def add_tree(self, tree, name, max_depth=inf):
+        """
+        Add a tree to the population.
+
+        :param tree: Tree to add.
+        :param name: Name of the individual (without extension).
+        :param max_depth: Trees deeper than this limit are not added.
+        :return: Reference to the new individual (None if it was not added).
+        """
+        if tree.depth > max_depth:
+            return None
+
+        fn = join(self.directory, name + self.tree_extension)
+        Tree.codec(fn).save(tree, fn)
+        index = self._recombination_index
+        if index.indexed == len(self.obj_list):
+            # Index the new tree right away, it is already in memory.
+            depths = index.name_depths(tree)
+            index.add(fn, depths)
+            index.save([(self.index_key(fn), depths)])
+            index.indexed += 1
+        self.obj_list.append(fn)
+        return fn
+
+    @staticmethod
+    def index_key(individual):
+        """
+        Key of an individual in the saved recombination index: name, size and
+        modification time of its file.
+        """
+        stat = os.stat(individual)
+        return basename(individual), stat.st_size, stat.st_mtime_ns
+
+    def load_tree(self, individual):
+        cache = self.cache
+        if cache is not None:
+            return cache.get(individual, self._load_lazy).tree()
+        return Tree.load(individual)
+
+    def load_lazy(self, individual):
+        """
+        Load an individual so that only the requested subtrees of it are
+        built (see LazyTree).
+        """
+        cache = self.cache
+        if cache is not None:
+            return cache.get(individual, self._load_lazy)
+        return self._load_lazy(individual)
+
+    def _load_lazy(self, individual):
+        return Tree.codec(individual).load_lazy(individual)
+
+    def preload(self):
+        """
+        Fill the cache with randomly chosen individuals (e.g., before forking
+        worker processes that will share them).
+        """
+        preload_individuals(self, self.obj_list)
+
+    def refresh(self):
+        """
+        The files of the population are listed when it is opened (and the
+        added trees are registered by add_tree), nothing to refresh.
+        """
+
+    @property
+    def size(self):
+        return len(self.obj_list)
+
+
+class RecordFile(object):
+    """
+    Base class of the populations stored in a single, append-only file::
+
+        magic, version (byte)
+        records: length (8 bytes, little-endian) and payload
+
+    New records are appended to a file opened in append mode with a single
+    write call (continued with the rest of the data only if the call writes
+    less), so that processes sharing the file can add records concurrently.
+    Incomplete trailing records (e.g., of a crashed writer) are ignored. The
+    header is checked when the file is opened, and new files are created
+    atomically together with their header (see _create). Subclasses define
+    the magic, the version and the description of the format, and implement
+    refresh, size and _load_lazy.
+    """
+
+    extension = None
+    magic = None
+    version = None
+    # Name of the format in the error messages.
+    description = None
+
+    _length = struct.Struct('<Q')
+
+    def __init__(self, fn, cache_size=0):
+        self.fn = fn
+        self.cache_size = cache_size
+        self._recombination_index = RecombinationIndex(fn + '.index')
+        try:
+            with open(fn, 'rb') as f:
+                self._check_header(f.read(len(self.magic) + 1))
+        except FileNotFoundError:
+            self._create()
+        self._reset()
+
+    def _create(self):
+        # A new file is written with its header under a temporary name and
+        # linked to its final name, which fails if the file exists already.
+        # Thus, processes creating the same file concurrently never see (or
+        # append to) a file without header, and only one of them creates it.
+        fd, tmp = tempfile.mkstemp(dir=dirname(abspath(self.fn)), prefix='.' + basename(self.fn) + '.')
+        try:
+            with os.fdopen(fd, 'wb') as f:
+                f.write(self.magic + bytes([self.version]))
+            try:
+                os.link(tmp, self.fn)
+            except FileExistsError:
+                with open(self.fn, 'rb') as f:
+                    self._check_header(f.read(len(self.magic) + 1))
+        finally:
+            os.remove(tmp)
+
+    def _reset(self):
+        self._end = len(self.magic) + 1
+
+    def __getstate__(self):
+        # File handles, mappings and read records are reopened and reread by
+        # the unpickled copy.
+        return {'fn': self.fn, 'cache_size': self.cache_size, '_recombination_index': self._recombination_index}
+
+    def __setstate__(self, state):
+        self.__dict__.update(state)
+        self._reset()
+
+    @property
+    def cache(self):
+        return TreeCache.instance(self.fn, self.cache_size) if self.cache_size > 0 else None
+
+    def close(self):
+        self._reset()
+
+    def refresh(self):
+        """
+        Read the records appended to the file since the last access.
+        """
+        raise NotImplementedError()
+
+    @property
+    def size(self):
+        raise NotImplementedError()
+
+    def _check_header(self, header):
+        if header[:len(self.magic)] != self.magic:
+            raise ValueError('{fn} is not a {description} (magic mismatch).'.format(fn=self.fn, description=self.description))
+        if header[len(self.magic)] > self.version:
+            raise ValueError('Unsupported {description} version: {version} (latest supported: {latest}).'.format(description=self.description, version=header[len(self.magic)], latest=self.version))
+
+    def _records(self, data, offset):
+        # Iterate over the (start, end) ranges of the payloads of the complete
+        # records of the data from offset.
+        size, header = len(data), self._length.size
+        while offset + header <= size:
+            length = self._length.unpack_from(data, offset)[0]
+            if offset + header + length > size:
+                break
+            yield offset + header, offset + header + length
+            offset += header + length
+
+    def _append(self, records):
+        data = memoryview(b''.join(self._length.pack(len(record)) + record for record in records))
+        with open(self.fn, 'ab', buffering=0) as f:
+            while data:
+                data = data[f.write(data):]
+
+    def random_individuals(self, n=1):
+        return random.sample(range(self.size), n)
+
+    def recombination_index(self):
+        """
+        Get the RecombinationIndex of the file, updated with the individuals
+        appended since the last call.
+        """
+        self._recombination_index.update(self, range(self.size))
+        return self._recombination_index
+
+    def load_tree(self, individual):
+        cache = self.cache
+        if cache is not None:
+            return cache.get(individual, self._load_lazy).tree()
+        return self._load_tree(individual)
+
+    def _load_tree(self, individual):
+        return self._load_lazy(individual).tree()
+
+    def load_lazy(self, individual):
+        cache = self.cache
+        if cache is not None:
+            return cache.get(individual, self._load_lazy)
+        return self._load_lazy(individual)
+
+    def _load_lazy(self, individual):
+        raise NotImplementedError()
+
+    def preload(self):
+        """
+        Fill the cache with randomly chosen individuals (e.g., before forking
+        worker processes that will share them).
+        """
+        preload_individuals(self, range(self.size))
+
+
+class PopulationDB(RecordFile):
+    """
+    Population of trees stored in a single, append-only database file (see
+    RecordFile) with the magic b'GRDB', where the records are binary encoded
+    trees (see BinaryTreeCodec).
+
+    Individuals are referred to by the index of their records. The file is
+    memory mapped for reading and the offsets of the records are collected by
+    skipping over the record lengths, thus neither a directory scan at startup
+    nor opening a file per tree is needed. Records appended by other
+    processes (or by other instances) become visible at the next access.
+    """
+
+    extension = '.grdb'
+    magic = b'GRDB'
+    version = 1
+    description = 'population database'
+
+    codec = BinaryTreeCodec()
+
+    def _reset(self):
+        super()._reset()
+        self._file = None
+        self._mmap = None
+        self._offsets = array('Q')
+        self._lengths = array('Q')
+
+    def close(self):
+        if self._mmap is not None:
+            self._mmap.close()
+            self._file.close()
+        self._reset()
+
+    def refresh(self):
+        """
+        Map the records appended to the database since the last access.
+        """
+        size = os.path.getsize(self.fn)
+        if self._mmap is not None and size == len(self._mmap):
+            return
+
+        if self._mmap is not None:
+            self._mmap.close()
+        else:
+            self._file = open(self.fn, 'rb')
+        self._mmap = mmap.mmap(self._file.fileno(), 0, access=mmap.ACCESS_READ)
+        data = self._mmap
+
+        end = self._end
+        for start, end in self._records(data, self._end):
+            self._offsets.append(start)
+            self._lengths.append(end - start)
+        self._end = end
+
+    def add_tree(self, tree, name=None, max_depth=inf):
+        """
+        Append a tree to the database.
+
+        :param tree: Tree to add.
+        :param name: Unused, records have no names.
+        :param max_depth: Trees deeper than this limit are not added.
+        :return: Always None, as the index of the new record is only known
+            after the next refresh.
+        """
+        if tree.depth > max_depth:
+            return None
+
+        self.add_records([self.codec.encode(tree)])
+        return None
+
+    def add_records(self, records):
+        """
+        Append already encoded trees (see codec) to the database with a single
+        write call.
+
+        :param records: List of encoded trees.
+        """
+        self._append(records)
+
+    def record(self, individual):
+        """
+        Get the encoded tree (see codec) of an individual as stored in the
+        database (e.g., to copy it to another database with add_records).
+        """
+        if self._mmap is None or individual >= len(self._offsets):
+            self.refresh()
+        offset = self._offsets[individual]
+        return self._mmap[offset:offset + self._lengths[individual]]
+
+    def index_key(self, individual):
+        """
+        Key of an individual in the saved recombination index: index and
+        digest of its record.
+        """
+        if self._mmap is None or individual >= len(self._offsets):
+            self.refresh()
+        offset = self._offsets[individual]
+        # The view is released before the mapping may be closed by refresh.
+        with memoryview(self._mmap) as data:
+            return individual, blake2b(data[offset:offset + self._lengths[individual]], digest_size=16).hexdigest()
+
+    def _load_tree(self, individual):
+        return self.codec.decode(self.record(individual))
+
+    def _load_lazy(self, individual):
+        return self.codec.decode_lazy(self.record(individual))
+
+    @property
+    def size(self):
+        self.refresh()
+        return len(self._offsets)
+
+
+class SubtreeStore(RecordFile):
+    """
+    Population of trees stored in a single, append-only file (see RecordFile)
+    with the magic b'GRSS', where structurally identical subtrees are stored
+    only once (hash-consing). The records consist of a kind (byte) and a
+    payload::
+
+        node (kind 0): is_lexer (byte), name and src (varint length plus one,
+            0 for None, followed by UTF-8 bytes; src is only present for lexer
+            nodes), number of children (varint) and the digests of the
+            children
+        tree (kind 1): digest of the root
+
+    A node is identified by the digest (16-byte blake2b) of its payload, which
+    covers the digests of its children. Thus, identical subtrees - within a
+    tree or across the trees of the population - refer to the same records,
+    and adding a tree appends only the records of the subtrees not stored
+    yet, plus its tree record (the records written twice by racing processes
+    are deduplicated at read). The distinct nodes are also kept only once in
+    memory, shared by all the trees of the population.
+
+    Individuals are referred to by the index of their tree records. Loaded
+    individuals are expanded into the columns of EncodedLazyTree, so their
+    nodes are only built when they are materialized, and modifications (e.g.,
+    splice) create new trees: the stored subtrees are never modified, they are
+    copied on write.
+    """
+
+    extension = '.grss'
+    magic = b'GRSS'
+    version = 1
+    description = 'subtree store'
+
+    _digest_size = 16
+
+    def _reset(self):
+        super()._reset()
+        # Distinct nodes keyed by digest: (is_lexer, name, src, child digests).
+        self._nodes = dict()
+        self._trees = []
+
+    def refresh(self):
+        """
+        Read the records appended to the store since the last access.
+        """
+        if os.path.getsize(self.fn) == self._end:
+            return
+
+        with open(self.fn, 'rb') as f:
+            f.seek(self._end)
+            data = memoryview(f.read())
+
+        nodes, trees = self._nodes, self._trees
+        end = 0
+        for start, end in self._records(data, 0):
+            if data[start] == 0:
+                payload = data[start + 1:end]
+                digest = blake2b(payload, digest_size=self._digest_size).digest()
+                if digest not in nodes:
+                    nodes[digest] = self._decode_node(payload)
+            else:
+                trees.append(bytes(data[start + 1:end]))
+        self._end += end
+
+    @staticmethod
+    def _encode_string(f, value):
+        if value is None:
+            write_varint(f, 0)
+            return
+        value = value.encode('utf-8', errors='surrogatepass')
+        write_varint(f, len(value) + 1)
+        f.write(value)
+
+    @staticmethod
+    def _decode_string(data, offset):
+        length, offset = read_varint(data, offset)
+        if not length:
+            return None, offset
+        return str(data[offset:offset + length - 1], 'utf-8', errors='surrogatepass'), offset + length - 1
+
+    def _encode_node(self, is_lexer, name, src, children):
+        f = ChunkWriter()
+        f.write(bytes([is_lexer]))
+        self._encode_string(f, name)
+        if is_lexer:
+            self._encode_string(f, src)
+        write_varint(f, len(children))
+        for digest in children:
+            f.write(digest)
+        return f.getvalue()
+
+    def _decode_node(self, data):
+        is_lexer = bool(data[0])
+        name, offset = self._decode_string(data, 1)
+        src = None
+        if is_lexer:
+            src, offset = self._decode_string(data, offset)
+        count, offset = read_varint(data, offset)
+        size = self._digest_size
+        return is_lexer, name, src, tuple(bytes(data[offset + i * size:offset + (i + 1) * size]) for i in range(count))
+
+    def add_tree(self, tree, name=None, max_depth=inf):
+        """
+        Append a tree to the store (only its subtrees not stored yet are
+        written).
+
+        :param tree: Tree to add.
+        :param name: Unused, trees have no names.
+        :param max_depth: Trees deeper than this limit are not added.
+        :return: Always None, as the index of the new tree is only known
+            after the next refresh.
+        """
+        if tree.depth > max_depth:
+            return None
+
+        self.refresh()
+        nodes = self._nodes
+        records = []
+        # Keyed by the nodes, not by their ids, as the views of flat trees are
+        # recreated at every access (but compare equal).
+        digests = dict()
+        stack = [(tree.root, False)]
+        while stack:
+            node, expanded = stack.pop()
+            if node.children and not expanded:
+                stack.append((node, True))
+                stack.extend((child, False) for child in node.children)
+                continue
+
+            is_lexer = isinstance(node, UnlexerRule)
+            src = node.src if is_lexer else None
+            children = tuple(digests.pop(child) for child in node.children)
+            payload = self._encode_node(is_lexer, node.name, src, children)
+            digest = blake2b(payload, digest_size=self._digest_size).digest()
+            digests[node] = digest
+            if digest not in nodes:
+                nodes[digest] = (is_lexer, node.name, src, children)
+                records.append(b'\0' + payload)
+        records.append(b'\1' + digests[tree.root])
+
+        self._append(records)
+        return None
+
+    def index_key(self, individual):
+        """
+        Key of an individual in the saved recombination index: index and root
+        digest of its tree.
+        """
+        if individual >= len(self._trees):
+            self.refresh()
+        return individual, self._trees[individual].hex()
+
+    def _load_lazy(self, individual):
+        # Expand the shared nodes of the tree into preorder columns (see
+        # BinaryTreeCodec.encode_nodes).
+        if individual >= len(self._trees):
+            self.refresh()
+        nodes = self._nodes
+        names, name_ids = [None], {None: 0}
+        strings, string_ids = [None], {None: 0}
+        kind_names, srcs, parents, sizes, levels, depths = (array('Q') for _ in range(6))
+        index = dict()
+        stack = [(self._trees[individual], 0)]
+        while stack:
+            digest, parent = stack.pop()
+            if digest is None:
+                # Marker of a finished subtree, parent holds the index of its root.
+                sizes[parent] = len(sizes) - parent
+                grand_parent = parents[parent] - 1
+                if grand_parent >= 0 and depths[grand_parent] <= depths[parent]:
+                    depths[grand_parent] = depths[parent] + 1
+                continue
+
+            is_lexer, name, src, children = nodes[digest]
+            node_idx = len(kind_names)
+            name_id = name_ids.get(name)
+            if name_id is None:
+                name_id = name_ids[name] = len(names)
+                names.append(name)
+            string_id = string_ids.get(src)
+            if string_id is None:
+                string_id = string_ids[src] = len(strings)
+                strings.append(src)
+            kind_names.append(name_id << 1 | is_lexer)
+            srcs.append(string_id)
+            parents.append(parent)
+            sizes.append(1)
+            levels.append(levels[parent - 1] + 1 if parent else 0)
+            depths.append(0)
+            if name_id not in index:
+                index[name_id] = array('Q')
+            index[name_id].append(node_idx)
+
+            stack.append((None, node_idx))
+            stack.extend((child, node_idx + 1) for child in reversed(children))
+
+        return EncodedLazyTree(names, strings, {'kind_name': kind_names, 'src': srcs, 'parent': parents, 'size': sizes, 'level': levels, 'depth': depths}, index)
+
+    @property
+    def size(self):
+        self.refresh()
+        return len(self._trees)
+
+    @property
+    def node_count(self):
+        """
+        Number of the distinct nodes stored.
+        """
+        self.refresh()
+        return len(self._nodes)
+
+
+def preload_individuals(population, individuals):
+    cache = population.cache
+    if cache is None:
+        return
+    for individual in random.sample(individuals, min(cache.size - len(cache), len(individuals))):
+        if individual not in cache:
+            cache.put(individual, population._load_lazy(individual))
+
+
+def open_population(path, cache_size=0):
+    """
+    Open a population database or a subtree store (if path has the extension
+    of PopulationDB or SubtreeStore) or a directory population.
+
+    :param path: Path to the population.
+    :param cache_size: Maximum number of decoded individuals to keep in memory
+        per process (0 disables caching).
+    """
+    if path.endswith(PopulationDB.extension):
+        return PopulationDB(path, cache_size=cache_size)
+    if path.endswith(SubtreeStore.extension):
+        return SubtreeStore(path, cache_size=cache_size)
+    return Population(path, cache_size=cache_size)
+
+
+def is_population_file(path):
+    """
+    Check whether a path refers to a single-file population (a population
+    database or a subtree store) instead of a directory.
+    """
+    return path.endswith((PopulationDB.extension, SubtreeStore.extension))
@@ -6,24 +6,32 @@
 # This file may not be copied, modified, or distributed except
 # according to those terms.
 
+import hashlib
+import importlib
+import os
+import pickle
 import re
+import sys
 
 from argparse import ArgumentParser
 from collections import defaultdict, OrderedDict
-from itertools import chain
-from math import inf
+from heapq import heappop, heappush
+from itertools import chain, count
+from math import inf, isfinite
+from multiprocessing import Pool
 from os import getcwd, makedirs
-from os.path import dirname, exists, join
+from os.path import abspath, basename, dirname, exists, join
 from pkgutil import get_data
 from shutil import copy, rmtree
 from sys import maxunicode
+from tempfile import mkdtemp, NamedTemporaryFile
 
 import autopep8
 
 from antlr4 import CommonTokenStream, FileStream, ParserRuleContext
 from jinja2 import Environment
 
-from .cli import add_antlr_argument, add_disable_cleanup_argument, add_log_level_argument, add_version_argument, process_antlr_argument, process_log_level_argument
+from .cli import add_antlr_argument, add_disable_cleanup_argument, add_jobs_argument, add_log_level_argument, add_version_argument, logger, process_antlr_argument, process_log_level_argument
 from .parser_builder import build_grammars
 from .pkgdata import __version__, default_antlr_path
 
@@ -39,6 +47,9 @@ class Node(object):
         self.id = id
         self.out_neighbours = []
         self.min_depth = inf
+        self.max_depth = inf
+        self.max_size = inf
+        self.expected_size = inf
 
 
 class RuleNode(Node):
@@ -97,6 +108,11 @@ class AlternationNode(Node):
         self.idx = idx
         self.conditions = conditions
 
+    @property
+    def static(self):
+        # Alternations without predicates can use precomputed weights.
+        return all(condition == '1' for condition in self.conditions)
+
 
 class AlternativeNode(Node):
 
@@ -144,6 +160,34 @@ def printable_ranges(lower_bound, upper_bound):
     return ranges
 
 
+def _literal_length(src):
+    # Number of characters of an escaped literal (e.g., \n or \u0041).
+    return len(re.sub(r'\\(u\{[0-9a-fA-F]+\}|u[0-9a-fA-F]{4}|.)', '_', src))
+
+
+def _cpp_string(src):
+    # C++ string literal (UTF-8 encoded) of an escaped literal of the grammar.
+    # Every byte that is not printable ASCII is written as an octal escape,
+    # which (unlike hex escapes) cannot swallow the following characters.
+    escapes = {'n': '\n', 'r': '\r', 'b': '\b', 't': '\t', 'f': '\f'}
+
+    def unescape(match):
+        escaped = match.group(1)
+        if len(escaped) > 1:
+            return chr(int(escaped[1:].strip('{}'), 16))
+        return escapes.get(escaped, escaped)
+
+    result = []
+    for byte in re.sub(r'\\(u\{[0-9a-fA-F]+\}|u[0-9a-fA-F]{4}|.)', unescape, src).encode('utf-8'):
+        if byte in b'"\\':
+            result.append('\\' + chr(byte))
+        elif 0x20 <= byte < 0x7f and byte != ord('?'):
+            result.append(chr(byte))
+        else:
+            result.append('\\{0:03o}'.format(byte))
+    return '"' + ''.join(result) + '"'
+
+
 def multirange_diff(r1_list, r2_list):
     def range_diff(r1, r2):
         s1, e1 = r1
@@ -204,6 +248,94 @@ class GrammarGraph(object):
     def imag_rules(self):
         return (vertex for vertex in self.vertices.values() if isinstance(vertex, ImagRuleNode))
 
+    @property
+    def alternation_sizes(self):
+        """
+        Expected sizes of the alternatives of the alternations (see
+        calc_sizes), keyed by the id of the rule and the index of the
+        alternation within the rule.
+        """
+        return {key: [child.expected_size for child in node.out_neighbours] for key, node in self._decisions(AlternationNode)}
+
+    @property
+    def quantifier_sizes(self):
+        """
+        Expected sizes of one repetition of the quantified expressions (see
+        calc_sizes), keyed by the id of the rule and the index of the
+        quantifier within the rule.
+        """
+        return {key: sum(child.expected_size for child in node.out_neighbours) for key, node in self._decisions(QuantifierNode)}
+
+    def _decisions(self, cls):
+        for rule in self.rules:
+            # The body of a rule is a tree up to the references to rules.
+            stack = list(rule.out_neighbours)
+            while stack:
+                node = stack.pop()
+                if isinstance(node, RuleNode):
+                    continue
+                if isinstance(node, cls):
+                    yield (rule.id, node.idx), node
+                stack.extend(node.out_neighbours)
+
+    @property
+    def rule_structures(self):
+        """
+        Structures of the bodies of the parser rules, as Python source code of
+        nested tuples (see grammarinator.runtime.find_repetitions), keyed by
+        the id of the rule. Rules with actions or charsets are left out, as
+        the children they generate cannot be matched against their
+        structure.
+        """
+        def structure(nodes):
+            items = []
+            for node in nodes:
+                if isinstance(node, (RuleNode, ImagRuleNode)):
+                    items.append('(\'r\', \'{id}\')'.format(id=node.id))
+                elif isinstance(node, LiteralNode):
+                    # Quoted the same way as by the template of the literals.
+                    items.append('(\'l\', \'' + node.src + '\')')
+                elif isinstance(node, AlternationNode):
+                    items.append('(\'a\', ({alts},))'.format(alts=', '.join(structure(child.out_neighbours) for child in node.out_neighbours)))
+                elif isinstance(node, QuantifierNode):
+                    items.append('(\'q\', {idx}, {min}, {max}, {body})'.format(idx=node.idx, min=node.min, max=node.max, body=structure(node.out_neighbours)))
+                elif isinstance(node, (ActionNode, CharsetNode)):
+                    raise ValueError(node)
+                # Lambdas and variables generate no nodes.
+            return '(\'s\', ({items}))'.format(items=''.join(item + ', ' for item in items).rstrip(' '))
+
+        structures = dict()
+        for rule in self.rules:
+            if rule.type != 'UnparserRule':
+                continue
+            try:
+                structures[rule.id] = structure(rule.out_neighbours)
+            except ValueError:
+                pass
+        return structures
+
+    @property
+    def static_alternations(self):
+        return (vertex for vertex in self.vertices.values() if isinstance(vertex, AlternationNode) and vertex.static)
+
+    def __getstate__(self):
+        # Edges are saved as vertex ids, otherwise pickle would recurse along
+        # the (possibly very long) paths of the graph.
+        state = self.__dict__.copy()
+        state['vertices'] = [(vertex.__class__, dict(vertex.__dict__, out_neighbours=[node.id for node in vertex.out_neighbours]))
+                             for vertex in self.vertices.values()]
+        return state
+
+    def __setstate__(self, state):
+        vertices = OrderedDict()
+        for cls, vertex_state in state['vertices']:
+            vertex = cls.__new__(cls)
+            vertex.__dict__.update(vertex_state)
+            vertices[vertex.id] = vertex
+        for vertex in vertices.values():
+            vertex.out_neighbours = [vertices[ident] for ident in vertex.out_neighbours]
+        self.__dict__.update(state, vertices=vertices)
+
     def add_node(self, node):
         self.vertices[node.id] = node
         return node.id
@@ -213,37 +345,207 @@ class GrammarGraph(object):
         assert to in self.vertices, '{to} not in vertices.'.format(to=to)
         self.vertices[frm].out_neighbours.append(self.vertices[to])
 
-    def calc_min_depths(self):
-        min_depths = defaultdict(lambda: inf)
-        changed = True
+    def _components(self):
+        """
+        Strongly connected components of the graph (iterative Tarjan
+        algorithm), in reverse topological order, i.e., every component
+        comes after the components reachable from it.
 
-        while changed:
-            changed = False
-            for ident in self.vertices:
-                selector = min if isinstance(self.vertices[ident], AlternationNode) else max
-                min_depth = selector((min_depths[node.id] + int(isinstance(self.vertices[node.id], RuleNode))
-                                      for node in self.vertices[ident].out_neighbours if not isinstance(node, QuantifierNode) or node.min >= 1), default=0)
+        :return: List of (list of vertex ids, recursive) tuples, where
+            recursive tells whether the component contains a cycle.
+        """
+        index, lowlink = dict(), dict()
+        on_stack = set()
+        stack, components = [], []
+
+        for start in self.vertices:
+            if start in index:
+                continue
+
+            work = [(start, 0)]
+            while work:
+                ident, child_idx = work.pop()
+                if child_idx == 0:
+                    index[ident] = lowlink[ident] = len(index)
+                    stack.append(ident)
+                    on_stack.add(ident)
+
+                children = self.vertices[ident].out_neighbours
+                if child_idx > 0:
+                    # Returning from the previous child.
+                    lowlink[ident] = min(lowlink[ident], lowlink[children[child_idx - 1].id])
+
+                while child_idx < len(children):
+                    child = children[child_idx].id
+                    child_idx += 1
+                    if child not in index:
+                        work.append((ident, child_idx))
+                        work.append((child, 0))
+                        break
+                    if child in on_stack:
+                        lowlink[ident] = min(lowlink[ident], index[child])
+                else:
+                    if lowlink[ident] == index[ident]:
+                        component = []
+                        while True:
+                            member = stack.pop()
+                            on_stack.discard(member)
+                            component.append(member)
+                            if member == ident:
+                                break
+                        recursive = len(component) > 1 or any(child.id == ident for child in children)
+                        components.append((component, recursive))
+
+        return components
 
-                if min_depth < min_depths[ident]:
-                    min_depths[ident] = min_depth
-                    changed = True
+    def calc_min_depths(self):
+        """
+        Calculate the minimum depth of the derivations of every node, i.e.,
+        the number of rule levels needed below the node. Alternations take
+        the minimum over their alternatives, other nodes the maximum over
+        their mandatory children (quantified children with zero minimum are
+        optional). The fixed point is computed in a single pass in increasing
+        order of depth (like Dijkstra's algorithm): a node is finalized when
+        its best alternative or its last mandatory child is finalized.
+        """
+        parents = defaultdict(list)
+        pending = dict()
+        min_depths = dict()
+        best = dict()
+        # Entries are (depth, serial, id): ids of different types must not be
+        # compared.
+        heap = []
+        serial = count()
+        for ident, vertex in self.vertices.items():
+            children = [node for node in vertex.out_neighbours if not isinstance(node, QuantifierNode) or node.min >= 1]
+            for child in children:
+                parents[child.id].append((ident, int(isinstance(child, RuleNode))))
+            if isinstance(vertex, AlternationNode):
+                pending[ident] = None
+            else:
+                pending[ident] = len(children)
+                best[ident] = 0
+            if not children:
+                heappush(heap, (0, next(serial), ident))
+
+        while heap:
+            depth, _, ident = heappop(heap)
+            if ident in min_depths:
+                continue
+            min_depths[ident] = depth
+
+            for parent, weight in parents[ident]:
+                if parent in min_depths:
+                    continue
+                candidate = depth + weight
+                if pending[parent] is None:
+                    if candidate < best.get(parent, inf):
+                        best[parent] = candidate
+                        heappush(heap, (candidate, next(serial), parent))
+                else:
+                    # A child can be mandatory multiple times.
+                    pending[parent] -= 1
+                    best[parent] = max(best[parent], candidate)
+                    if not pending[parent]:
+                        heappush(heap, (best[parent], next(serial), parent))
 
         # Lift the minimal depths of the alternatives to the alternations, where the decision will happen.
-        for ident in min_depths:
-            if isinstance(self.vertices[ident], AlternationNode):
-                assert all(min_depths[node.id] < inf for node in self.vertices[ident].out_neighbours), '{ident} has an alternative that isn\'t reachable.'.format(ident=ident)
-                min_depths[ident] = [min_depths[node.id] for node in self.vertices[ident].out_neighbours]
+        for ident, vertex in self.vertices.items():
+            if isinstance(vertex, AlternationNode) and ident in min_depths:
+                assert all(node.id in min_depths for node in vertex.out_neighbours), '{ident} has an alternative that isn\'t reachable.'.format(ident=ident)
+                min_depths[ident] = [min_depths[node.id] for node in vertex.out_neighbours]
 
         # Remove the lifted Alternatives and check for infinite derivations.
-        for ident in list(min_depths.keys()):
-            if isinstance(self.vertices[ident], AlternativeNode):
-                del min_depths[ident]
+        for ident, vertex in self.vertices.items():
+            if isinstance(vertex, AlternativeNode):
+                min_depths.pop(ident, None)
             else:
-                assert min_depths[ident] != inf, 'Rule with infinite derivation: %s' % ident
+                assert ident in min_depths, 'Rule with infinite derivation: %s' % ident
 
         for ident, min_depth in min_depths.items():
             self.vertices[ident].min_depth = min_depth
 
+    def calc_max_depths(self, components=None):
+        """
+        Calculate the maximum depth of the derivations of every node (with the
+        same metric as calc_min_depths), i.e., the remaining depth that is
+        enough to generate any derivation of the node. Nodes that can reach a
+        recursion get infinite maximum depth.
+
+        :param components: Result of _components (computed if None).
+        """
+        for component, recursive in components or self._components():
+            for ident in component:
+                vertex = self.vertices[ident]
+                vertex.max_depth = inf if recursive else max((child.max_depth + int(isinstance(child, RuleNode)) for child in vertex.out_neighbours), default=0)
+
+    def calc_sizes(self, components=None):
+        """
+        Calculate the maximum and the expected size (number of output
+        characters) of the derivations of every node. Expected sizes assume
+        the decisions of DefaultModel (uniform choice between the
+        alternatives, predicates counted as 1, and quantifiers continuing with
+        1/2 probability) and no depth limit. Recursive components are solved by
+        fixed-point iteration, and they get infinite expected size if the
+        iteration diverges (i.e., if derivations are infinite with positive
+        probability).
+
+        :param components: Result of _components (computed if None).
+        """
+        def weight(condition):
+            try:
+                return float(condition)
+            except ValueError:
+                return 1.0
+
+        def sizes(vertex, get):
+            if isinstance(vertex, LiteralNode):
+                size = _literal_length(vertex.src)
+                return size, size
+            if isinstance(vertex, CharsetNode):
+                return 1, 1
+
+            children = [get(child) for child in vertex.out_neighbours]
+            if isinstance(vertex, AlternationNode):
+                weights = [weight(condition) for condition in vertex.conditions]
+                total = sum(weights)
+                return (max((child[0] for child in children), default=0),
+                        sum(w * child[1] for w, child in zip(weights, children)) / total if total else 0)
+
+            max_size, expected_size = sum(child[0] for child in children), sum(child[1] for child in children)
+            if isinstance(vertex, QuantifierNode):
+                # Expected number of the optional repetitions.
+                extra = 1.0 if vertex.max == inf else 1 - 0.5 ** (vertex.max - vertex.min)
+                max_size = max_size * vertex.max if max_size else 0
+                expected_size = expected_size * (vertex.min + extra)
+            return max_size, expected_size
+
+        for component, recursive in components or self._components():
+            if not recursive:
+                vertex = self.vertices[component[0]]
+                vertex.max_size, vertex.expected_size = sizes(vertex, lambda child: (child.max_size, child.expected_size))
+                continue
+
+            # Unless every derivation of the component is empty, its nodes can
+            # be repeated without limit.
+            expected = {ident: 0.0 for ident in component}
+            for _ in range(1000):
+                previous = dict(expected)
+                for ident in component:
+                    expected[ident] = sizes(self.vertices[ident], lambda child: (0, previous[child.id] if child.id in previous else child.expected_size))[1]
+                if all(abs(expected[ident] - previous[ident]) <= 1e-9 * max(1.0, expected[ident]) for ident in component):
+                    break
+                if any(value > 1e12 for value in expected.values()):
+                    expected = dict.fromkeys(component, inf)
+                    break
+            else:
+                expected = dict.fromkeys(component, inf)
+
+            for ident in component:
+                vertex = self.vertices[ident]
+                vertex.expected_size = expected[ident]
+                vertex.max_size = inf if expected[ident] > 0 else 0
+
 
 def build_graph(antlr_parser_cls, actions, lexer_root, parser_root):
 
@@ -600,39 +902,113 @@ def build_graph(antlr_parser_cls, actions, lexer_root, parser_root):
             build_rules(root)
 
     graph.calc_min_depths()
+    components = graph._components()
+    graph.calc_max_depths(components)
+    graph.calc_sizes(components)
     return graph
 
 
+def _read_text(fn):
+    with open(fn, 'r') as f:
+        return f.read()
+
+
+def _file_digest(fn):
+    with open(fn, 'rb') as f:
+        return hashlib.sha256(f.read()).hexdigest()
+
+
 class FuzzerFactory(object):
     """
     Class that generates fuzzers from grammars.
+
+    The ANTLR v4 meta-parser (the parser of the grammar files) is built with
+    the ANTLR tool only if no up-to-date build exists in the cache directory
+    (or in the working directory without cache). With a cache directory, the
+    grammar graphs are also cached, keyed by the content of the processed
+    grammar files and the processing settings.
     """
-    def __init__(self, lang, work_dir=None, antlr=default_antlr_path):
+
+    runtime_resources = {
+        'cpp': ['Generator.hpp', 'Listener.hpp', 'Model.hpp', 'Rule.hpp', 'Runtime.hpp', 'Serializer.hpp', 'Tool.hpp'],
+    }
+
+    antlr_resources = ['ANTLRv4Lexer.g4', 'ANTLRv4Parser.g4', 'LexBasic.g4', 'LexerAdaptor.py']
+
+    def __init__(self, lang, work_dir=None, antlr=default_antlr_path, cache_dir=None):
         """
         :param lang: Language of the generated code.
         :param work_dir: Directory to generate fuzzers into.
         :param antlr: Path to the ANTLR jar.
+        :param cache_dir: Directory to cache the built meta-parser and the
+            grammar graphs in (no caching if None).
         """
         self.lang = lang
         env = Environment(trim_blocks=True,
                           lstrip_blocks=True,
                           keep_trailing_newline=False)
         env.filters['substitute'] = lambda s, frm, to: re.sub(frm, to, str(s))
+        env.filters['cpp_string'] = _cpp_string
+        env.tests['finite'] = isfinite
         self.template = env.from_string(get_data(__package__, join('resources', 'codegen', 'GeneratorTemplate.' + lang + '.jinja')).decode('utf-8'))
         self.work_dir = work_dir or getcwd()
+        self.cache_dir = cache_dir
+
+        self.antlr_lexer_cls, self.antlr_parser_cls = self._build_meta_parser(antlr)
+
+    def _build_meta_parser(self, antlr):
+        resources = [(resource, get_data(__package__, join('resources', 'antlr', resource))) for resource in self.antlr_resources]
+
+        # The build depends on the grammars of the meta-parser and on the ANTLR
+        # tool.
+        digest = hashlib.sha256()
+        for resource, data in resources:
+            digest.update(resource.encode('utf-8'))
+            digest.update(data)
+        if exists(antlr):
+            with open(antlr, 'rb') as f:
+                digest.update(f.read())
+        else:
+            digest.update(antlr.encode('utf-8'))
+        key = digest.hexdigest()
+
+        antlr_dir = join(self.cache_dir, 'antlr', key) if self.cache_dir else join(self.work_dir, 'antlr')
+        stamp = join(antlr_dir, '.key')
+        if not exists(stamp) or _read_text(stamp) != key:
+            # Build in a temporary directory and move it to its place when
+            # ready, so that concurrent processes never see partial builds.
+            base_dir = dirname(antlr_dir)
+            makedirs(base_dir, exist_ok=True)
+            build_dir = mkdtemp(prefix='.antlr-', dir=base_dir)
+            try:
+                for resource, data in resources:
+                    with open(join(build_dir, resource), 'wb') as f:
+                        f.write(data)
+                build_grammars([resource for resource, _ in resources], build_dir, antlr=antlr)
+                with open(stamp.replace(antlr_dir, build_dir, 1), 'w') as f:
+                    f.write(key)
+
+                if not self.cache_dir:
+                    # Outdated build in the working directory.
+                    rmtree(antlr_dir, ignore_errors=True)
+                try:
+                    os.rename(build_dir, antlr_dir)
+                except OSError:
+                    # Another process has finished the same build meanwhile.
+                    pass
+            finally:
+                # Nothing is left behind if the build failed or lost the race.
+                if build_dir in sys.path:
+                    sys.path.remove(build_dir)
+                rmtree(build_dir, ignore_errors=True)
+        else:
+            logger.debug('Using the meta-parser built in %s.', antlr_dir)
 
-        antlr_dir = join(self.work_dir, 'antlr')
-        makedirs(antlr_dir, exist_ok=True)
-
-        # Copy the grammars from the package to the given working directory.
-        antlr_resources = ['ANTLRv4Lexer.g4', 'ANTLRv4Parser.g4', 'LexBasic.g4', 'LexerAdaptor.py']
-        for resource in antlr_resources:
-            with open(join(antlr_dir, resource), 'wb') as f:
-                f.write(get_data(__package__, join('resources', 'antlr', resource)))
-
-        self.antlr_lexer_cls, self.antlr_parser_cls, _ = build_grammars(antlr_resources, antlr_dir, antlr=antlr)
+        if antlr_dir not in sys.path:
+            sys.path.append(antlr_dir)
+        return (getattr(importlib.import_module(name), name) for name in ['ANTLRv4Lexer', 'ANTLRv4Parser'])
 
-    def generate_fuzzer(self, grammars, *, options=None, encoding='utf-8', lib_dir=None, actions=True, pep8=False):
+    def generate_fuzzer(self, grammars, *, options=None, encoding='utf-8', lib_dir=None, actions=True, pep8=False, specialize=False):
         """
         Generates fuzzers from grammars.
 
@@ -641,30 +1017,78 @@ class FuzzerFactory(object):
         :param encoding: Grammar file encoding.
         :param lib_dir: Alternative directory to look for imports.
         :param actions: Boolean to enable or disable grammar actions.
-        :param pep8: Boolean to enable pep8 to beautify the generated fuzzer source.
+        :param pep8: Boolean to enable pep8 to beautify the generated fuzzer source (Python target only).
+        :param specialize: Boolean to specialize the generated rules by the remaining depth: inline depth control and
+            skip the depth checks of rules that cannot exceed the remaining depth (Python target only).
         """
-        lexer_root, parser_root = None, None
-
         for grammar in grammars:
-            if grammar.endswith('.g4'):
-                root = self._parse(grammar, encoding, lib_dir)
-                # Lexer and/or combined grammars are processed first to evaluate TOKEN_REF-s.
-                if root.grammarDecl().grammarType().LEXER() or not root.grammarDecl().grammarType().PARSER():
-                    lexer_root = root
-                else:
-                    parser_root = root
-            else:
+            if not grammar.endswith('.g4'):
                 copy(grammar, self.work_dir)
 
-        graph = build_graph(self.antlr_parser_cls, actions, lexer_root, parser_root)
+        graph = self._load_graph(grammars, encoding, lib_dir, actions)
         graph.options.update(options or {})
 
-        src = self.template.render(graph=graph, version=__version__).lstrip()
+        src = self.template.render(graph=graph, version=__version__, specialize=specialize).lstrip()
         with open(join(self.work_dir, graph.name + '.' + self.lang), 'w') as f:
-            if pep8:
+            if pep8 and self.lang == 'py':
                 src = autopep8.fix_code(src)
             f.write(src)
 
+        # Generators of compiled targets need the sources of their runtime next to them.
+        if self.lang in self.runtime_resources:
+            runtime_dir = join(self.work_dir, 'grammarinator', 'runtime')
+            makedirs(runtime_dir, exist_ok=True)
+            for resource in self.runtime_resources[self.lang]:
+                with open(join(runtime_dir, resource), 'wb') as f:
+                    f.write(get_data(__package__, join('resources', 'runtime', self.lang, 'grammarinator', 'runtime', resource)))
+
+    def _load_graph(self, grammars, encoding, lib_dir, actions):
+        """
+        Get the graph of the grammars, either from the cache or by parsing
+        them. Cache entries are keyed by the paths and contents of the given
+        grammars and by the settings, and they also record the imported
+        grammars, which are checked at lookup.
+        """
+        grammars = [grammar for grammar in grammars if grammar.endswith('.g4')]
+        cache_fn = None
+        if self.cache_dir:
+            digest = hashlib.sha256(repr((__version__, encoding, abspath(lib_dir) if lib_dir else None, actions)).encode('utf-8'))
+            for grammar in grammars:
+                digest.update(abspath(grammar).encode('utf-8'))
+                digest.update(_file_digest(grammar).encode('ascii'))
+            cache_fn = join(self.cache_dir, 'graphs', digest.hexdigest() + '.pickle')
+
+            if exists(cache_fn):
+                try:
+                    with open(cache_fn, 'rb') as f:
+                        imports, graph = pickle.load(f)
+                    if all(exists(fn) and _file_digest(fn) == fn_digest for fn, fn_digest in imports):
+                        logger.debug('Using the cached graph of %s.', ', '.join(grammars))
+                        return graph
+                except Exception as e:
+                    logger.warning('Failed to load cached graph %s.', cache_fn, exc_info=e)
+
+        lexer_root, parser_root = None, None
+        parsed = []
+        for grammar in grammars:
+            root = self._parse(grammar, encoding, lib_dir, parsed)
+            # Lexer and/or combined grammars are processed first to evaluate TOKEN_REF-s.
+            if root.grammarDecl().grammarType().LEXER() or not root.grammarDecl().grammarType().PARSER():
+                lexer_root = root
+            else:
+                parser_root = root
+
+        graph = build_graph(self.antlr_parser_cls, actions, lexer_root, parser_root)
+
+        if cache_fn:
+            imports = [(abspath(fn), _file_digest(fn)) for fn in parsed if fn not in grammars]
+            makedirs(dirname(cache_fn), exist_ok=True)
+            with NamedTemporaryFile(dir=dirname(cache_fn), delete=False) as f:
+                pickle.dump((imports, graph), f, protocol=pickle.HIGHEST_PROTOCOL)
+            os.replace(f.name, cache_fn)
+
+        return graph
+
     @staticmethod
     def _collect_imports(root, base_dir, lib_dir):
         imports = set()
@@ -679,12 +1103,14 @@ class FuzzerFactory(object):
                         imports.add(join(base_dir, grammar_fn))
         return imports
 
-    def _parse(self, grammar, encoding, lib_dir):
+    def _parse(self, grammar, encoding, lib_dir, parsed=None):
         work_list = {grammar}
         root = None
 
         while work_list:
             grammar = work_list.pop()
+            if parsed is not None:
+                parsed.append(grammar)
 
             antlr_parser = self.antlr_parser_cls(CommonTokenStream(self.antlr_lexer_cls(FileStream(grammar, encoding=encoding))))
             current_root = antlr_parser.grammarSpec()
@@ -703,6 +1129,41 @@ class FuzzerFactory(object):
         return root
 
 
+def group_grammars(files):
+    """
+    Split the input files of multiple fuzzers into the inputs of the
+    individual fuzzers: a combined grammar or a pair of lexer and parser
+    grammars (named <Name>Lexer.g4 and <Name>Parser.g4) belong to one fuzzer,
+    other files (e.g., additional sources) belong to every fuzzer.
+
+    :param files: List of grammar files and additional sources.
+    :return: List of file lists.
+    """
+    groups = OrderedDict()
+    others = []
+    for fn in files:
+        if not fn.endswith('.g4'):
+            others.append(fn)
+            continue
+        name = re.sub(r'^(.+?)(Lexer|Parser)?\.g4$', r'\1', basename(fn))
+        groups.setdefault(join(dirname(fn), name), []).append(fn)
+    return [group + others for group in groups.values()]
+
+
+_worker_factory = None
+
+
+def _init_worker(lang, work_dir, antlr, cache_dir):
+    global _worker_factory  # pylint: disable=global-statement
+    _worker_factory = FuzzerFactory(lang, work_dir, antlr, cache_dir=cache_dir)
+
+
+def _generate_fuzzer(args):
+    grammars, kwargs = args
+    _worker_factory.generate_fuzzer(grammars, **kwargs)
+    return grammars
+
+
 def execute():
     parser = ArgumentParser(description='Grammarinator: Processor', epilog="""
         The tool processes a grammar in ANTLR v4 format (*.g4, either separated
@@ -714,7 +1175,7 @@ def execute():
                         help='ANTLR grammar files describing the expected format to generate.')
     parser.add_argument('-D', metavar='OPT=VAL', dest='options', default=list(), action='append',
                         help='set/override grammar-level option')
-    parser.add_argument('--language', choices=['py'], default='py',
+    parser.add_argument('--language', choices=['py', 'cpp'], default='py',
                         help='language of the generated code (choices: %(choices)s; default: %(default)s)')
     parser.add_argument('--no-actions', dest='actions', default=True, action='store_false',
                         help='do not process inline actions.')
@@ -723,9 +1184,17 @@ def execute():
     parser.add_argument('--lib', metavar='DIR',
                         help='alternative location of import grammars.')
     parser.add_argument('--pep8', default=False, action='store_true',
-                        help='enable autopep8 to format the generated fuzzer.')
+                        help='enable autopep8 to format the generated fuzzer (Python target only).')
+    parser.add_argument('--specialize', default=False, action='store_true',
+                        help='specialize the generated rules by the remaining depth (inline depth control and skip unnecessary depth checks; Python target only).')
     parser.add_argument('-o', '--out', metavar='DIR', default=getcwd(),
                         help='temporary working directory (default: %(default)s).')
+    parser.add_argument('--batch', default=False, action='store_true',
+                        help='create a separate fuzzer from every grammar (a combined grammar, or a pair of lexer and parser grammars '
+                             'named <Name>Lexer.g4 and <Name>Parser.g4); non-grammar files are copied next to every fuzzer.')
+    parser.add_argument('--cache-dir', metavar='DIR',
+                        help='directory to cache the built ANTLR meta-parser and the processed grammars in (no caching by default).')
+    add_jobs_argument(parser)
     add_disable_cleanup_argument(parser)
     add_antlr_argument(parser)
     add_log_level_argument(parser)
@@ -748,7 +1217,18 @@ def execute():
     process_log_level_argument(args)
     process_antlr_argument(args)
 
-    FuzzerFactory(args.language, args.out, args.antlr).generate_fuzzer(args.grammar, options=options, encoding=args.encoding, lib_dir=args.lib, actions=args.actions, pep8=args.pep8)
+    factory = FuzzerFactory(args.language, args.out, args.antlr, cache_dir=args.cache_dir)
+    kwargs = dict(options=options, encoding=args.encoding, lib_dir=args.lib, actions=args.actions, pep8=args.pep8, specialize=args.specialize)
+    groups = group_grammars(args.grammar) if args.batch else [args.grammar]
+    if args.jobs > 1 and len(groups) > 1:
+        # The meta-parser is already built by the factory of this process,
+        # the workers only load it.
+        with Pool(min(args.jobs, len(groups)), initializer=_init_worker, initargs=(args.language, args.out, args.antlr, args.cache_dir)) as pool:
+            for grammars in pool.imap_unordered(_generate_fuzzer, [(grammars, kwargs) for grammars in groups]):
+                logger.debug('Processed %s.', ', '.join(grammars))
+    else:
+        for grammars in groups:
+            factory.generate_fuzzer(grammars, **kwargs)
 
     if args.cleanup:
         rmtree(join(args.out, 'antlr'), ignore_errors=True)
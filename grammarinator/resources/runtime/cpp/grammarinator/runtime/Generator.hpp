@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+ *
+ * Licensed under the BSD 3-Clause License
+ * <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+ * This file may not be copied, modified, or distributed except
+ * according to those terms.
+ */
+
+#ifndef GRAMMARINATOR_RUNTIME_GENERATOR_HPP
+#define GRAMMARINATOR_RUNTIME_GENERATOR_HPP
+
+#include <memory>
+#include <vector>
+
+#include "Listener.hpp"
+#include "Model.hpp"
+#include "Rule.hpp"
+
+namespace grammarinator {
+namespace runtime {
+
+class Generator {
+public:
+    Model* model;
+    double max_depth;
+    std::vector<Listener*> listeners;
+
+    explicit Generator(Model* model = nullptr, double max_depth = inf) : model(model), max_depth(max_depth) {
+        if (!model) {
+            default_model.reset(new DefaultModel());
+            this->model = default_model.get();
+        }
+    }
+
+    virtual ~Generator() = default;
+
+    void enter_rule(Rule* node) {
+        for (Listener* listener : listeners) {
+            listener->enter_rule(node);
+        }
+    }
+
+    void exit_rule(Rule* node) {
+        for (auto it = listeners.rbegin(); it != listeners.rend(); ++it) {
+            (*it)->exit_rule(node);
+        }
+    }
+
+private:
+    std::unique_ptr<Model> default_model;
+};
+
+// Scope guard counterpart of the depthcontrol decorator of the Python runtime:
+// decrements the available depth of the generator while a rule is being
+// generated.
+class DepthControl {
+public:
+    explicit DepthControl(Generator* generator) : generator(generator) {
+        --generator->max_depth;
+    }
+
+    DepthControl(const DepthControl&) = delete;
+    DepthControl& operator=(const DepthControl&) = delete;
+
+    ~DepthControl() {
+        ++generator->max_depth;
+    }
+
+private:
+    Generator* generator;
+};
+
+} // namespace runtime
+} // namespace grammarinator
+
+#endif // GRAMMARINATOR_RUNTIME_GENERATOR_HPP
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+ *
+ * Licensed under the BSD 3-Clause License
+ * <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+ * This file may not be copied, modified, or distributed except
+ * according to those terms.
+ */
+
+#ifndef GRAMMARINATOR_RUNTIME_MODEL_HPP
+#define GRAMMARINATOR_RUNTIME_MODEL_HPP
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Rule.hpp"
+
+namespace grammarinator {
+namespace runtime {
+
+constexpr double inf = std::numeric_limits<double>::infinity();
+
+// List of half-open [start, end) code point ranges.
+using Charset = std::vector<std::pair<int, int>>;
+
+inline std::string utf8(int codepoint) {
+    std::string result;
+    if (codepoint < 0x80) {
+        result += static_cast<char>(codepoint);
+    } else if (codepoint < 0x800) {
+        result += static_cast<char>(0xC0 | (codepoint >> 6));
+        result += static_cast<char>(0x80 | (codepoint & 0x3F));
+    } else if (codepoint < 0x10000) {
+        result += static_cast<char>(0xE0 | (codepoint >> 12));
+        result += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        result += static_cast<char>(0x80 | (codepoint & 0x3F));
+    } else {
+        result += static_cast<char>(0xF0 | (codepoint >> 18));
+        result += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+        result += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        result += static_cast<char>(0x80 | (codepoint & 0x3F));
+    }
+    return result;
+}
+
+// Decision model interface of the generators.
+class Model {
+public:
+    virtual ~Model() = default;
+
+    // Choose an alternative of the idx-th alternation of the node's rule.
+    virtual int choice(const Rule* node, int idx, const std::vector<double>& weights) = 0;
+
+    // Decide whether the idx-th quantifier of the node's rule should produce
+    // its cnt-th (0-based) repetition.
+    virtual bool quantify(const Rule* node, int idx, int cnt, int min, double max) = 0;
+
+    // Choose a character (encoded in UTF-8) from the idx-th charset of the
+    // node's rule.
+    virtual std::string charset(const Rule* node, int idx, const Charset& chars) = 0;
+};
+
+class DefaultModel : public Model {
+public:
+    explicit DefaultModel(std::uint64_t seed = std::random_device()()) : rng(seed) { }
+
+    int choice(const Rule* /*node*/, int /*idx*/, const std::vector<double>& weights) override {
+        double sum = 0;
+        for (double w : weights) {
+            sum += w;
+        }
+        double r = std::uniform_real_distribution<double>(0, sum)(rng);
+        double upto = 0;
+        for (size_t i = 0; i < weights.size(); ++i) {
+            if (upto + weights[i] >= r) {
+                return static_cast<int>(i);
+            }
+            upto += weights[i];
+        }
+        throw std::logic_error("Shouldn't get here.");
+    }
+
+    bool quantify(const Rule* /*node*/, int /*idx*/, int cnt, int min, double max) override {
+        return cnt < min || (cnt < max && std::bernoulli_distribution(0.5)(rng));
+    }
+
+    std::string charset(const Rule* /*node*/, int /*idx*/, const Charset& chars) override {
+        long total = 0;
+        for (const auto& range : chars) {
+            total += range.second - range.first;
+        }
+        long r = std::uniform_int_distribution<long>(0, total - 1)(rng);
+        for (const auto& range : chars) {
+            if (r < range.second - range.first) {
+                return utf8(range.first + static_cast<int>(r));
+            }
+            r -= range.second - range.first;
+        }
+        throw std::logic_error("Shouldn't get here.");
+    }
+
+protected:
+    std::mt19937_64 rng;
+};
+
+// Decorator of a model that decreases the weights of the alternatives after
+// they had been chosen.
+class CooldownModel : public Model {
+public:
+    explicit CooldownModel(Model* model, double cooldown = 1.0) : model(model), cooldown(cooldown) { }
+
+    int choice(const Rule* node, int idx, const std::vector<double>& weights) override {
+        std::vector<double> cooled(weights);
+        for (size_t i = 0; i < cooled.size(); ++i) {
+            cooled[i] *= weight(node->name, static_cast<int>(i));
+        }
+        int i = model->choice(node, idx, cooled);
+        weights_[std::make_pair(node->name, i)] = weight(node->name, i) * cooldown;
+        return i;
+    }
+
+    bool quantify(const Rule* node, int idx, int cnt, int min, double max) override {
+        return model->quantify(node, idx, cnt, min, max);
+    }
+
+    std::string charset(const Rule* node, int idx, const Charset& chars) override {
+        return model->charset(node, idx, chars);
+    }
+
+private:
+    double weight(const std::string& name, int i) const {
+        auto it = weights_.find(std::make_pair(name, i));
+        return it != weights_.end() ? it->second : 1.0;
+    }
+
+    Model* model;
+    double cooldown;
+    std::map<std::pair<std::string, int>, double> weights_;
+};
+
+} // namespace runtime
+} // namespace grammarinator
+
+#endif // GRAMMARINATOR_RUNTIME_MODEL_HPP
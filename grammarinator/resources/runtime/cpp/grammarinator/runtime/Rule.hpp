@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+ *
+ * Licensed under the BSD 3-Clause License
+ * <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+ * This file may not be copied, modified, or distributed except
+ * according to those terms.
+ */
+
+#ifndef GRAMMARINATOR_RUNTIME_RULE_HPP
+#define GRAMMARINATOR_RUNTIME_RULE_HPP
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace grammarinator {
+namespace runtime {
+
+// Tree node of the generated tests. A node owns its children, i.e., deleting
+// the root of a tree releases the whole tree.
+class Rule {
+public:
+    std::string name;
+    Rule* parent = nullptr;
+    std::vector<Rule*> children;
+    int level = -1;
+    int depth = -1;
+
+    explicit Rule(const std::string& name, Rule* parent = nullptr) : name(name) {
+        if (parent) {
+            parent->add_child(this);
+        }
+    }
+
+    Rule(const Rule&) = delete;
+    Rule& operator=(const Rule&) = delete;
+
+    virtual ~Rule() {
+        for (Rule* child : children) {
+            delete child;
+        }
+    }
+
+    Rule* left_sibling() const {
+        if (!parent) {
+            return nullptr;
+        }
+        auto it = std::find(parent->children.begin(), parent->children.end(), this);
+        return it != parent->children.end() && it != parent->children.begin() ? *(it - 1) : nullptr;
+    }
+
+    Rule* right_sibling() const {
+        if (!parent) {
+            return nullptr;
+        }
+        auto it = std::find(parent->children.begin(), parent->children.end(), this);
+        return it != parent->children.end() && it + 1 != parent->children.end() ? *(it + 1) : nullptr;
+    }
+
+    Rule* last_child() const {
+        return children.empty() ? nullptr : children.back();
+    }
+
+    void insert_child(size_t idx, Rule* node) {
+        if (!node) {
+            return;
+        }
+        node->parent = this;
+        children.insert(children.begin() + idx, node);
+    }
+
+    void add_child(Rule* node) {
+        if (!node) {
+            return;
+        }
+        children.push_back(node);
+        node->parent = this;
+    }
+
+    // Replace the current node with another one in the tree. The replaced
+    // node is detached but not released, it's the caller's responsibility to
+    // delete it.
+    Rule* replace(Rule* node) {
+        if (parent && node != this) {
+            *std::find(parent->children.begin(), parent->children.end(), this) = node;
+            node->parent = parent;
+            parent = nullptr;
+        }
+        return node;
+    }
+
+    // Detach the current node from its parent (without releasing it).
+    void remove() {
+        if (parent) {
+            parent->children.erase(std::find(parent->children.begin(), parent->children.end(), this));
+            parent = nullptr;
+        }
+    }
+
+    virtual bool is_lexer_rule() const = 0;
+
+    virtual std::string str() const {
+        std::string result;
+        for (const Rule* child : children) {
+            result += child->str();
+        }
+        return result;
+    }
+};
+
+class UnparserRule : public Rule {
+public:
+    explicit UnparserRule(const std::string& name, Rule* parent = nullptr) : Rule(name, parent) { }
+
+    bool is_lexer_rule() const override { return false; }
+};
+
+class UnlexerRule : public Rule {
+public:
+    std::string src;
+
+    explicit UnlexerRule(const std::string& name, Rule* parent = nullptr) : Rule(name, parent) { }
+    UnlexerRule(const std::string& name, const std::string& src, Rule* parent) : Rule(name, parent), src(src) { }
+
+    bool is_lexer_rule() const override { return true; }
+
+    std::string str() const override {
+        return !src.empty() ? src : Rule::str();
+    }
+};
+
+} // namespace runtime
+} // namespace grammarinator
+
+#endif // GRAMMARINATOR_RUNTIME_RULE_HPP
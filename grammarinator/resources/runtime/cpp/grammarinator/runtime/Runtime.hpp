@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+ *
+ * Licensed under the BSD 3-Clause License
+ * <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+ * This file may not be copied, modified, or distributed except
+ * according to those terms.
+ */
+
+#ifndef GRAMMARINATOR_RUNTIME_RUNTIME_HPP
+#define GRAMMARINATOR_RUNTIME_RUNTIME_HPP
+
+#include "Generator.hpp"
+#include "Listener.hpp"
+#include "Model.hpp"
+#include "Rule.hpp"
+#include "Serializer.hpp"
+#include "Tool.hpp"
+
+#endif // GRAMMARINATOR_RUNTIME_RUNTIME_HPP
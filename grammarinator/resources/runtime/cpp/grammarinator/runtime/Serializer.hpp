@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+ *
+ * Licensed under the BSD 3-Clause License
+ * <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+ * This file may not be copied, modified, or distributed except
+ * according to those terms.
+ */
+
+#ifndef GRAMMARINATOR_RUNTIME_SERIALIZER_HPP
+#define GRAMMARINATOR_RUNTIME_SERIALIZER_HPP
+
+#include <string>
+
+#include "Rule.hpp"
+
+namespace grammarinator {
+namespace runtime {
+
+inline std::string default_serializer(const Rule* root) {
+    return root->str();
+}
+
+inline std::string simple_space_serializer(const Rule* root) {
+    std::string src;
+
+    struct Walker {
+        std::string& src;
+
+        void walk(const Rule* node) {
+            for (const Rule* child : node->children) {
+                walk(child);
+
+                if (!node->is_lexer_rule()) {
+                    src += ' ';
+                }
+            }
+
+            if (node->is_lexer_rule()) {
+                src += static_cast<const UnlexerRule*>(node)->src;
+            }
+        }
+    };
+
+    Walker{src}.walk(root);
+    return src;
+}
+
+} // namespace runtime
+} // namespace grammarinator
+
+#endif // GRAMMARINATOR_RUNTIME_SERIALIZER_HPP
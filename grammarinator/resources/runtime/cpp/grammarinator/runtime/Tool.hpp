@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+ *
+ * Licensed under the BSD 3-Clause License
+ * <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+ * This file may not be copied, modified, or distributed except
+ * according to those terms.
+ */
+
+#ifndef GRAMMARINATOR_RUNTIME_TOOL_HPP
+#define GRAMMARINATOR_RUNTIME_TOOL_HPP
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+
+#include "Generator.hpp"
+#include "Model.hpp"
+#include "Rule.hpp"
+#include "Serializer.hpp"
+
+namespace grammarinator {
+namespace runtime {
+
+// Minimal counterpart of grammarinator-generate for generators compiled from
+// the C++ target. The generator class G is expected to be created from
+// GeneratorTemplate.cpp.jinja (or be a subclass of such a class).
+template<class G>
+int tool_main(int argc, char* argv[]) {
+    std::string rule = G::default_rule() ? G::default_rule() : "";
+    std::string out = "test_%d";
+    std::string serializer = "default";
+    double max_depth = inf;
+    double cooldown = 1.0;
+    long n = 1;
+    std::uint64_t seed = std::random_device()();
+
+    auto usage = [&argv]() {
+        std::cerr << "usage: " << argv[0] << " [-r NAME] [-d NUM] [-c NUM] [-n NUM] [-o FILE] [-s {default,simple_space}] [--random-seed NUM]" << std::endl;
+        return 2;
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return usage();
+        }
+        std::string value = argv[++i];
+        if (arg == "-r" || arg == "--rule") {
+            rule = value;
+        } else if (arg == "-d" || arg == "--max-depth") {
+            max_depth = std::strtod(value.c_str(), nullptr);
+        } else if (arg == "-c" || arg == "--cooldown") {
+            cooldown = std::strtod(value.c_str(), nullptr);
+        } else if (arg == "-n") {
+            n = std::strtol(value.c_str(), nullptr, 10);
+        } else if (arg == "-o" || arg == "--out") {
+            out = value;
+        } else if (arg == "-s" || arg == "--serializer") {
+            serializer = value;
+        } else if (arg == "--random-seed") {
+            seed = std::strtoull(value.c_str(), nullptr, 10);
+        } else {
+            return usage();
+        }
+    }
+
+    auto rule_it = G::rules().find(rule);
+    if (rule_it == G::rules().end()) {
+        std::cerr << "Unknown rule: " << rule << std::endl;
+        return 1;
+    }
+    if (rule_it->second.min_depth > max_depth) {
+        std::cerr << rule << " cannot be generated within the given depth: " << max_depth << " (min needed: " << rule_it->second.min_depth << ")." << std::endl;
+        return 1;
+    }
+
+    std::string (*serialize)(const Rule*) = nullptr;
+    if (serializer == "default") {
+        serialize = default_serializer;
+    } else if (serializer == "simple_space") {
+        serialize = simple_space_serializer;
+    } else {
+        return usage();
+    }
+
+    if (out.find("%d") == std::string::npos) {
+        out += "%d";
+    }
+
+    DefaultModel default_model(seed);
+    CooldownModel cooldown_model(&default_model, cooldown);
+    Model* model = cooldown < 1 ? static_cast<Model*>(&cooldown_model) : &default_model;
+
+    for (long i = 0; i < n; ++i) {
+        G generator(model, max_depth);
+        std::unique_ptr<Rule> root((generator.*(rule_it->second.fn))(nullptr));
+
+        std::string fn = out;
+        fn.replace(fn.find("%d"), 2, std::to_string(i));
+        std::ofstream f(fn, std::ios::binary);
+        if (!f) {
+            std::cerr << "Cannot open " << fn << std::endl;
+            return 1;
+        }
+        if (root) {
+            f << serialize(root.get());
+        }
+    }
+    return 0;
+}
+
+} // namespace runtime
+} // namespace grammarinator
+
+#endif // GRAMMARINATOR_RUNTIME_TOOL_HPP
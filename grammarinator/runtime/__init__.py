@@ -5,8 +5,13 @@
 # This file may not be copied, modified, or distributed except
 # according to those terms.
 
+from .charset import Charset
 from .default_listener import DefaultListener
 from .dispatching_listener import DispatchingListener
-from .generator import depthcontrol, Generator
-from .serializer import simple_space_serializer
+from .flat_tree import flatten, FlatRule, FlatTree, FlatUnlexerRule, FlatUnparserRule
+from .generator import AlternationWeights, BudgetExceededError, depthcontrol, Generator
+from .profiling_listener import ProfilingListener, RuleProfile
+from .repetitions import find_repetitions, Repetition
+from .serializer import ParserSeparator, Serializer, simple_space_serializer
 from .tree import BaseRule, Tree, UnlexerRule, UnparserRule
+from .tree_codec import BinaryTreeCodec, EncodedLazyTree, EncodedTree, LazyTree, PickleTreeCodec, TreeCodec
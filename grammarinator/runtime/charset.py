@@ -0,0 +1,72 @@
+# Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+#
+# Licensed under the BSD 3-Clause License
+# <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+# This file may not be copied, modified, or distributed except
+# according to those terms.
+
+import random
+
+from bisect import bisect_right
+from itertools import accumulate
+
+
+class Charset(object):
+    """
+    Sequence of character codes described by half-open [start, end) ranges,
+    without materializing the codes. It supports len(), indexing, iteration
+    and membership tests, thus it can be used everywhere where a list of
+    character codes was expected (e.g., by random.choice).
+    """
+
+    def __init__(self, ranges):
+        """
+        :param ranges: List of (start, end) code point ranges.
+        """
+        self.ranges = [(start, end) for start, end in ranges if end > start]
+        # Number of the codes in the ranges preceding (and including) each
+        # range.
+        self._offsets = list(accumulate(end - start for start, end in self.ranges))
+
+    def __len__(self):
+        return self._offsets[-1] if self._offsets else 0
+
+    def __getitem__(self, i):
+        if i < 0:
+            i += len(self)
+        if not 0 <= i < len(self):
+            raise IndexError('Charset index out of range.')
+        r = bisect_right(self._offsets, i)
+        return self.ranges[r][1] - (self._offsets[r] - i)
+
+    def __iter__(self):
+        for start, end in self.ranges:
+            yield from range(start, end)
+
+    def __contains__(self, code):
+        return any(start <= code < end for start, end in self.ranges)
+
+    def __repr__(self):
+        return '{cls}({ranges!r})'.format(cls=self.__class__.__name__, ranges=self.ranges)
+
+    def sample(self, n=1, rng=random):
+        """
+        Draw random characters (uniformly from all the codes of the ranges).
+
+        :param n: Number of characters to draw.
+        :param rng: Random number generator to use.
+        :return: String of n characters.
+        """
+        size = len(self)
+        rand = rng.random
+        if len(self.ranges) == 1:
+            start = self.ranges[0][0]
+            return ''.join([chr(start + int(rand() * size)) for _ in range(n)])
+
+        ranges, offsets = self.ranges, self._offsets
+        chars = []
+        for _ in range(n):
+            i = int(rand() * size)
+            r = bisect_right(offsets, i)
+            chars.append(chr(ranges[r][1] - offsets[r] + i))
+        return ''.join(chars)
@@ -13,3 +13,20 @@ class DefaultListener(object):
 
     def exit_rule(self, node):
         pass
+
+    def enter_handler(self, name):
+        """
+        Get the function to be called when a rule is entered (used by the
+        generator to skip the listeners that do nothing for a rule).
+
+        :param name: Name of the rule.
+        :return: Callable taking the node of the rule, or None.
+        """
+        return self.enter_rule if type(self).enter_rule is not DefaultListener.enter_rule else None
+
+    def exit_handler(self, name):
+        """
+        Get the function to be called when a rule is exited (see
+        enter_handler).
+        """
+        return self.exit_rule if type(self).exit_rule is not DefaultListener.exit_rule else None
@@ -0,0 +1,31 @@
+# Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+#
+# Licensed under the BSD 3-Clause License
+# <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+# This file may not be copied, modified, or distributed except
+# according to those terms.
+
+# Handler methods (or None) of the dispatching classes (listeners and models),
+# keyed by the class and the method prefix, and then by rule name.
+_handlers = dict()
+
+
+def resolve_handler(cls, prefix, name):
+    """
+    Get the handler method of a rule (e.g., ``enter_<name>`` of a listener or
+    ``choice_<name>`` of a model) of a class. The handlers are looked up once
+    per class, prefix and rule name.
+
+    :param cls: Class defining the handlers.
+    :param prefix: Prefix of the names of the handler methods.
+    :param name: Name of the rule (None for the unnamed nodes, which have no
+        handlers).
+    :return: The handler function (unbound) or None if not defined.
+    """
+    table = _handlers.get((cls, prefix))
+    if table is None:
+        table = _handlers[(cls, prefix)] = dict()
+    fn = table.get(name, resolve_handler)
+    if fn is resolve_handler:
+        fn = table[name] = getattr(cls, prefix + name, None) if name is not None else None
+    return fn
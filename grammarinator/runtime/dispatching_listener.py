@@ -6,16 +6,34 @@
 # according to those terms.
 
 from .default_listener import DefaultListener
+from .dispatch import resolve_handler
 
 
 class DispatchingListener(DefaultListener):
+    """
+    Listener dispatching the events of a node to the ``enter_<name>`` and
+    ``exit_<name>`` methods if the listener defines them for the name of the
+    node. The handlers are resolved once per listener class and rule name.
+    """
 
     def enter_rule(self, node):
-        fn = 'enter_' + node.name
-        if hasattr(self, fn):
-            getattr(self, fn)(node)
+        fn = resolve_handler(type(self), 'enter_', node.name)
+        if fn:
+            fn(self, node)
 
     def exit_rule(self, node):
-        fn = 'exit_' + node.name
-        if hasattr(self, fn):
-            getattr(self, fn)(node)
+        fn = resolve_handler(type(self), 'exit_', node.name)
+        if fn:
+            fn(self, node)
+
+    def enter_handler(self, name):
+        if type(self).enter_rule is not DispatchingListener.enter_rule:
+            return self.enter_rule
+        fn = resolve_handler(type(self), 'enter_', name)
+        return fn.__get__(self) if fn else None
+
+    def exit_handler(self, name):
+        if type(self).exit_rule is not DispatchingListener.exit_rule:
+            return self.exit_rule
+        fn = resolve_handler(type(self), 'exit_', name)
+        return fn.__get__(self) if fn else None
@@ -0,0 +1,376 @@
+# Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+#
+# Licensed under the BSD 3-Clause License
+# <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+# This file may not be copied, modified, or distributed except
+# according to those terms.
+
+from array import array
+
+from .tree import BaseRule, UnlexerRule, UnparserRule
+
+
+class FlatTree(object):
+    """
+    Arena that stores the nodes of trees in contiguous arrays instead of
+    separate node objects. Nodes are referred to by their index, the structure
+    is described by parent, first/last child and previous/next sibling indices
+    (-1 if missing), while the names and sources of the nodes are interned in
+    shared pools. The nodes are accessible through FlatUnparserRule and
+    FlatUnlexerRule views, which implement the API of BaseRule.
+    """
+
+    UNPARSER = 0
+    UNLEXER = 1
+
+    def __init__(self):
+        self.names = [None]
+        self.name_ids = {None: 0}
+        self.strings = [None]
+        self.string_ids = {None: 0}
+
+        self.kind = array('b')
+        self.name = array('i')
+        self.src = array('i')
+        self.parent = array('i')
+        self.first_child = array('i')
+        self.last_child = array('i')
+        self.prev_sibling = array('i')
+        self.next_sibling = array('i')
+        self.level = array('i')
+        self.depth = array('i')
+
+    def __len__(self):
+        return len(self.kind)
+
+    def intern_name(self, name):
+        name_id = self.name_ids.get(name)
+        if name_id is None:
+            name_id = len(self.names)
+            self.names.append(name)
+            self.name_ids[name] = name_id
+        return name_id
+
+    def intern_string(self, src):
+        string_id = self.string_ids.get(src)
+        if string_id is None:
+            string_id = len(self.strings)
+            self.strings.append(src)
+            self.string_ids[src] = string_id
+        return string_id
+
+    def new_node(self, kind, name=None, src=None):
+        """
+        Allocate a new, detached node in the arena.
+
+        :param kind: FlatTree.UNPARSER or FlatTree.UNLEXER.
+        :param name: Name of the node.
+        :param src: Source of the node (lexer nodes only).
+        :return: Index of the new node.
+        """
+        idx = len(self.kind)
+        self.kind.append(kind)
+        self.name.append(self.intern_name(name))
+        self.src.append(self.intern_string(src))
+        for links in (self.parent, self.first_child, self.last_child, self.prev_sibling, self.next_sibling, self.level, self.depth):
+            links.append(-1)
+        return idx
+
+    def children(self, idx):
+        child = self.first_child[idx]
+        while child != -1:
+            yield child
+            child = self.next_sibling[child]
+
+    def link(self, parent, idx, before=-1):
+        """
+        Link a detached node into the children of parent, in front of the
+        before node (or as last child if before is -1).
+        """
+        self.parent[idx] = parent
+        if before == -1:
+            prev = self.last_child[parent]
+            self.last_child[parent] = idx
+        else:
+            prev = self.prev_sibling[before]
+            self.prev_sibling[before] = idx
+        self.prev_sibling[idx] = prev
+        self.next_sibling[idx] = before
+        if prev == -1:
+            self.first_child[parent] = idx
+        else:
+            self.next_sibling[prev] = idx
+
+    def unlink(self, idx):
+        """
+        Detach a node (together with its subtree) from its parent. The node
+        remains allocated in the arena.
+        """
+        parent = self.parent[idx]
+        if parent == -1:
+            return
+        prev, nxt = self.prev_sibling[idx], self.next_sibling[idx]
+        if prev == -1:
+            self.first_child[parent] = nxt
+        else:
+            self.next_sibling[prev] = nxt
+        if nxt == -1:
+            self.last_child[parent] = prev
+        else:
+            self.prev_sibling[nxt] = prev
+        self.parent[idx] = self.prev_sibling[idx] = self.next_sibling[idx] = -1
+
+    def import_node(self, node):
+        """
+        Copy a tree (built from BaseRule objects or views of another arena)
+        into the arena.
+
+        :param node: Root of the tree to copy.
+        :return: Index of the copy of the root.
+        """
+        root = -1
+        stack = [(node, -1)]
+        while stack:
+            node, parent = stack.pop()
+            if isinstance(node, UnlexerRule):
+                idx = self.new_node(FlatTree.UNLEXER, node.name, node.src)
+            else:
+                idx = self.new_node(FlatTree.UNPARSER, node.name)
+            if parent == -1:
+                root = idx
+            else:
+                self.link(parent, idx)
+            stack.extend((child, idx) for child in reversed(node.children))
+        return root
+
+    def view(self, idx):
+        if idx == -1:
+            return None
+        view = object.__new__(FlatUnlexerRule if self.kind[idx] == FlatTree.UNLEXER else FlatUnparserRule)
+        view._tree = self
+        view._idx = idx
+        return view
+
+    def unflatten(self, idx):
+        """
+        Build a tree of UnparserRule and UnlexerRule objects from the subtree
+        of a node.
+        """
+        root = None
+        stack = [(idx, None)]
+        while stack:
+            idx, parent = stack.pop()
+            if self.kind[idx] == FlatTree.UNLEXER:
+                node = UnlexerRule(name=self.names[self.name[idx]], src=self.strings[self.src[idx]])
+            else:
+                node = UnparserRule(name=self.names[self.name[idx]])
+            if parent is None:
+                root = node
+            else:
+                parent.add_child(node)
+            stack.extend((child, node) for child in reversed(list(self.children(idx))))
+        return root
+
+    def str(self, idx):
+        parts = []
+        stack = [idx]
+        while stack:
+            idx = stack.pop()
+            if self.kind[idx] == FlatTree.UNLEXER and self.src[idx] and self.strings[self.src[idx]]:
+                parts.append(self.strings[self.src[idx]])
+                continue
+            child = self.last_child[idx]
+            while child != -1:
+                stack.append(child)
+                child = self.prev_sibling[child]
+        return ''.join(parts)
+
+
+def _view(tree, idx):
+    return tree.view(idx)
+
+
+def flatten(node):
+    """
+    Copy a tree into a new FlatTree arena.
+
+    :param node: Root of the tree to copy.
+    :return: View of the copied root.
+    """
+    tree = FlatTree()
+    return tree.view(tree.import_node(node))
+
+
+class FlatRule(object):
+    """
+    Mixin of the view classes of FlatTree nodes. Views are lightweight handles
+    (an arena and an index), two views are equal if they refer to the same
+    node. Note that the children property returns a tuple (a read-only
+    snapshot, so that in-place edits fail instead of being lost), the tree has
+    to be modified through the node API (add_child, insert_child, replace,
+    delete, etc.).
+    """
+
+    _kind = None
+    # The arena does not maintain node dictionaries, level or depth (see
+    # Tree.annotate).
+    _self_indexing = False
+
+    def __init__(self, *, name=None, parent=None, src=None):
+        # pylint: disable=super-init-not-called
+        if parent is None:
+            self._tree = FlatTree()
+        elif isinstance(parent, FlatRule):
+            self._tree = parent._tree
+        else:
+            raise TypeError('Parent of a flat node must be a flat node as well.')
+        self._idx = self._tree.new_node(self._kind, name, src)
+        if parent is not None:
+            self._tree.link(parent._idx, self._idx)
+
+    def __getattr__(self, item):
+        # Prevent child name lookup of BaseRule for internal attributes of
+        # partially initialized views.
+        if item.startswith('_'):
+            raise AttributeError(item)
+        return BaseRule.__getattr__(self, item)
+
+    def __eq__(self, other):
+        return isinstance(other, FlatRule) and self._tree is other._tree and self._idx == other._idx
+
+    def __ne__(self, other):
+        return not self == other
+
+    def __hash__(self):
+        return hash((id(self._tree), self._idx))
+
+    def __reduce__(self):
+        return _view, (self._tree, self._idx)
+
+    @property
+    def tree(self):
+        return self._tree
+
+    @property
+    def index(self):
+        return self._idx
+
+    @property
+    def name(self):
+        return self._tree.names[self._tree.name[self._idx]]
+
+    @name.setter
+    def name(self, value):
+        self._tree.name[self._idx] = self._tree.intern_name(value)
+
+    @property
+    def parent(self):
+        return self._tree.view(self._tree.parent[self._idx])
+
+    @parent.setter
+    def parent(self, node):
+        self._tree.unlink(self._idx)
+        if node is not None:
+            node.add_child(self)
+
+    @property
+    def children(self):
+        return tuple(self._tree.view(child) for child in self._tree.children(self._idx))
+
+    @property
+    def level(self):
+        level = self._tree.level[self._idx]
+        return level if level != -1 else None
+
+    @level.setter
+    def level(self, value):
+        self._tree.level[self._idx] = value if value is not None else -1
+
+    @property
+    def depth(self):
+        depth = self._tree.depth[self._idx]
+        return depth if depth != -1 else None
+
+    @depth.setter
+    def depth(self, value):
+        self._tree.depth[self._idx] = value if value is not None else -1
+
+    @property
+    def left_sibling(self):
+        return self._tree.view(self._tree.prev_sibling[self._idx])
+
+    @property
+    def right_sibling(self):
+        return self._tree.view(self._tree.next_sibling[self._idx])
+
+    @property
+    def last_child(self):
+        return self._tree.view(self._tree.last_child[self._idx])
+
+    @last_child.setter
+    def last_child(self, node):
+        last = self._tree.last_child[self._idx]
+        if last != -1:
+            self._tree.unlink(last)
+        self.add_child(node)
+
+    def _adopt(self, node):
+        # Get the index of a node in the arena of the current node, either by
+        # detaching it from its current position or by copying it.
+        if isinstance(node, FlatRule) and node._tree is self._tree:
+            self._tree.unlink(node._idx)
+            return node._idx
+        return self._tree.import_node(node)
+
+    def insert_child(self, idx, node):
+        if not node:
+            return
+
+        node_idx = self._adopt(node)
+        children = list(self._tree.children(self._idx))
+        self._tree.link(self._idx, node_idx, children[idx] if idx < len(children) else -1)
+
+    def add_child(self, node):
+        if node is None:
+            return
+
+        self._tree.link(self._idx, self._adopt(node))
+
+    def replace(self, node):
+        if self._tree.parent[self._idx] != -1 and node != self:
+            parent, nxt = self._tree.parent[self._idx], self._tree.next_sibling[self._idx]
+            self._tree.unlink(self._idx)
+            node_idx = self._adopt(node)
+            self._tree.link(parent, node_idx, nxt)
+            node = self._tree.view(node_idx)
+        return node
+
+    def delete(self):
+        self._tree.unlink(self._idx)
+
+    def deepcopy(self):
+        return flatten(self)
+
+    def unflatten(self):
+        return self._tree.unflatten(self._idx)
+
+    def __str__(self):
+        return self._tree.str(self._idx)
+
+
+class FlatUnparserRule(FlatRule, UnparserRule):
+
+    _kind = FlatTree.UNPARSER
+
+
+class FlatUnlexerRule(FlatRule, UnlexerRule):
+
+    _kind = FlatTree.UNLEXER
+
+    @property
+    def src(self):
+        return self._tree.strings[self._tree.src[self._idx]]
+
+    @src.setter
+    def src(self, value):
+        self._tree.src[self._idx] = self._tree.intern_string(value)
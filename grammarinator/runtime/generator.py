@@ -5,9 +5,13 @@
 # This file may not be copied, modified, or distributed except
 # according to those terms.
 
+from bisect import bisect_right
 from math import inf
+from time import perf_counter
 
-from ..model import DefaultModel
+from ..model import CumulativeWeights, DefaultModel
+from .flat_tree import FlatRule, FlatUnlexerRule, FlatUnparserRule
+from .tree import UnlexerRule, UnparserRule
 
 
 def depthcontrol(fn):
@@ -23,17 +27,151 @@ def depthcontrol(fn):
     return controlled_fn
 
 
+class AlternationWeights(object):
+    """
+    Precomputed weights of an alternation with static conditions. The
+    alternatives that cannot be generated within the remaining depth get zero
+    weight, thus the weights only change at the distinct minimum depths of the
+    alternatives. Calling the object with the remaining depth returns the
+    same CumulativeWeights object for every depth of such a bucket.
+    """
+
+    def __init__(self, min_depths, weights):
+        self._thresholds = sorted(set(min_depths))
+        self._buckets = [CumulativeWeights([w if d <= t else 0 for d, w in zip(min_depths, weights)]) for t in self._thresholds]
+        self._none = CumulativeWeights([0] * len(weights))
+
+    def __call__(self, max_depth):
+        i = bisect_right(self._thresholds, max_depth)
+        return self._buckets[i - 1] if i > 0 else self._none
+
+
+class BudgetExceededError(Exception):
+    """
+    Raised by Generator if the generation of a tree exceeds one of its
+    budgets.
+    """
+
+    def __init__(self, budget, limit):
+        """
+        :param budget: Name of the exceeded budget ('nodes', 'bytes' or
+            'time').
+        :param limit: Value of the exceeded budget.
+        """
+        super().__init__('The {budget} budget ({limit}) of the test is exceeded.'.format(budget=budget, limit=limit))
+        self.budget = budget
+        self.limit = limit
+
+
 class Generator(object):
 
-    def __init__(self, *, model=None, max_depth=inf):
+    # Number of rule entries and exits between two checks of the time budget.
+    time_check_interval = 64
+
+    def __init__(self, *, model=None, max_depth=inf, flat=False, max_nodes=inf, max_bytes=inf, max_time=inf):
+        """
+        :param model: Decision model of the generator (DefaultModel by default).
+        :param max_depth: Maximum recursion depth during generation.
+        :param flat: Boolean to build the tree into a FlatTree arena instead of
+            separate node objects.
+        :param max_nodes: Maximum number of nodes to create.
+        :param max_bytes: Maximum number of characters in the sources of the
+            created tokens.
+        :param max_time: Maximum number of seconds to spend generating (from
+            the instantiation of the generator).
+        """
         self.model = model or DefaultModel()
         self.max_depth = max_depth
         self.listeners = []
+        # The handlers of the listeners per rule name (see _handlers).
+        self._listener_handlers = dict()
+        self._handled_listeners = []
+        # The node classes instantiated by the generated rule methods.
+        self.unparser_rule_cls, self.unlexer_rule_cls = (FlatUnparserRule, FlatUnlexerRule) if flat else (UnparserRule, UnlexerRule)
+
+        # The budgets are checked at the entry and exit of every rule (see
+        # check_budget). If any of them is set, the node classes are wrapped to
+        # count the created nodes and characters.
+        self.max_nodes = max_nodes
+        self.max_bytes = max_bytes
+        self.max_time = max_time
+        self._budgeted = max_nodes < inf or max_bytes < inf or max_time < inf
+        self.node_count = 0
+        self.byte_count = 0
+        self._rule_count = 0
+        self._deadline = perf_counter() + max_time if max_time < inf else inf
+        if self._budgeted:
+            self.unparser_rule_cls = self._counted(self.unparser_rule_cls)
+            self.unlexer_rule_cls = self._counted(self.unlexer_rule_cls)
+
+    def _counted(self, cls):
+        # Subclass of the node class that counts the nodes and characters
+        # created by this generator (so that isinstance checks and further
+        # subclassing still work).
+        generator = self
+
+        class Counted(cls):
+
+            def __init__(self, **kwargs):
+                generator.node_count += 1
+                src = kwargs.get('src')
+                if src:
+                    generator.byte_count += len(src)
+                super().__init__(**kwargs)
+
+            if not issubclass(cls, FlatRule):
+                # Nodes are copied and pickled as instances of the original
+                # class (flat views are reduced to plain views anyway).
+                def __reduce__(self):
+                    return object.__new__, (cls,), self.__dict__
+
+        Counted.__name__ = Counted.__qualname__ = cls.__name__
+        return Counted
+
+    def check_budget(self):
+        """
+        Raise BudgetExceededError if any of the budgets is exceeded. The clock
+        is only read at every time_check_interval-th call.
+        """
+        if self.node_count > self.max_nodes:
+            raise BudgetExceededError('nodes', self.max_nodes)
+        if self.byte_count > self.max_bytes:
+            raise BudgetExceededError('bytes', self.max_bytes)
+        self._rule_count += 1
+        if not self._rule_count % self.time_check_interval and perf_counter() > self._deadline:
+            raise BudgetExceededError('time', self.max_time)
 
     def enter_rule(self, node):
-        for listener in self.listeners:
-            listener.enter_rule(node)
+        if self._budgeted:
+            self.check_budget()
+        for fn in self._handlers(node.name)[0]:
+            fn(node)
 
     def exit_rule(self, node):
-        for listener in reversed(self.listeners):
-            listener.exit_rule(node)
+        if self._budgeted:
+            self.check_budget()
+        for fn in self._handlers(node.name)[1]:
+            fn(node)
+
+    def _handlers(self, name):
+        # Only those listeners are called for a rule that handle it (see
+        # DefaultListener.enter_handler). The handlers are collected at the
+        # first use of every rule name, and recollected if the listeners
+        # changed.
+        if self._handled_listeners != self.listeners:
+            self._handled_listeners = list(self.listeners)
+            self._listener_handlers = dict()
+
+        handlers = self._listener_handlers.get(name)
+        if handlers is None:
+            enter, exit_ = [], []
+            for listener in self.listeners:
+                fn = listener.enter_handler(name) if hasattr(listener, 'enter_handler') else listener.enter_rule
+                if fn:
+                    enter.append(fn)
+            for listener in reversed(self.listeners):
+                fn = listener.exit_handler(name) if hasattr(listener, 'exit_handler') else listener.exit_rule
+                if fn:
+                    exit_.append(fn)
+            handlers = self._listener_handlers[name] = (enter, exit_)
+        return handlers
@@ -0,0 +1,155 @@
+# Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+#
+# Licensed under the BSD 3-Clause License
+# <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+# This file may not be copied, modified, or distributed except
+# according to those terms.
+
+import json
+
+from time import perf_counter
+
+from .default_listener import DefaultListener
+
+
+class RuleProfile(object):
+    """
+    Statistics of a rule collected by ProfilingListener.
+    """
+
+    __slots__ = ('calls', 'cum_time', 'self_time', 'size', 'levels')
+
+    def __init__(self):
+        self.calls = 0
+        self.cum_time = 0.0
+        self.self_time = 0.0
+        # Number of characters produced by the rule (including its subrules).
+        self.size = 0
+        # Histogram of the levels (number of enclosing rules) of the calls.
+        self.levels = dict()
+
+    def merge(self, other):
+        self.calls += other.calls
+        self.cum_time += other.cum_time
+        self.self_time += other.self_time
+        self.size += other.size
+        for level, cnt in other.levels.items():
+            self.levels[level] = self.levels.get(level, 0) + cnt
+
+    def to_json(self):
+        return {'calls': self.calls, 'cum_time': self.cum_time, 'self_time': self.self_time, 'size': self.size,
+                'levels': {str(level): cnt for level, cnt in sorted(self.levels.items())}}
+
+    @staticmethod
+    def from_json(data):
+        profile = RuleProfile()
+        profile.calls = data['calls']
+        profile.cum_time = data['cum_time']
+        profile.self_time = data['self_time']
+        profile.size = data['size']
+        profile.levels = {int(level): cnt for level, cnt in data['levels'].items()}
+        return profile
+
+
+class ProfilingListener(DefaultListener):
+    """
+    Listener collecting per-rule statistics of the generation: the number of
+    calls, the cumulative and self time (the latter excluding the time spent
+    in subrules), the number of produced characters, and the histogram of the
+    levels the rule was called at. The per-call bookkeeping is a stack push
+    and pop, and the size of a rule is computed from the sizes of its subrules
+    and the sources of its own tokens, thus no node is visited twice.
+    (Sizes reflect the tree at the exit of the rules, later modifications by
+    actions of enclosing rules are not accounted for.)
+    """
+
+    def __init__(self):
+        self.profiles = dict()
+        # Frames of the rules being generated: start time, time spent in
+        # subrules and size of the subrules.
+        self._stack = []
+        # Number of the frames of the rules being generated (to count the
+        # time of recursive calls only once in the cumulative time).
+        self._active = dict()
+
+    def enter_rule(self, node):
+        if node.parent is None:
+            # Start of a new tree (frames left behind by a failed generation
+            # are dropped).
+            self._stack.clear()
+            self._active.clear()
+        self._stack.append([perf_counter(), 0.0, 0])
+        self._active[node.name] = self._active.get(node.name, 0) + 1
+
+    def exit_rule(self, node):
+        end = perf_counter()
+        start, sub_time, size = self._stack.pop()
+        elapsed = end - start
+
+        # The sizes of the subrules are already counted, only the sources of
+        # the tokens (unnamed children) and of childless lexer rules remain.
+        for child in node.children:
+            if child.name is None:
+                size += len(getattr(child, 'src', None) or '')
+        if not node.children:
+            size += len(getattr(node, 'src', None) or '')
+
+        profile = self.profiles.get(node.name)
+        if profile is None:
+            profile = self.profiles[node.name] = RuleProfile()
+        profile.calls += 1
+        profile.self_time += elapsed - sub_time
+        profile.size += size
+        level = len(self._stack)
+        profile.levels[level] = profile.levels.get(level, 0) + 1
+
+        active = self._active[node.name] - 1
+        self._active[node.name] = active
+        if not active:
+            profile.cum_time += elapsed
+
+        if self._stack:
+            parent = self._stack[-1]
+            parent[1] += elapsed
+            parent[2] += size
+
+    def merge(self, profiles):
+        """
+        Add the statistics of another listener (e.g., of a worker process).
+
+        :param profiles: Dictionary of RuleProfile objects keyed by rule names.
+        """
+        for name, profile in profiles.items():
+            if name not in self.profiles:
+                self.profiles[name] = RuleProfile()
+            self.profiles[name].merge(profile)
+
+    def to_json(self):
+        return {name: profile.to_json() for name, profile in sorted(self.profiles.items())}
+
+    def dump(self, fn):
+        with open(fn, 'w') as f:
+            json.dump(self.to_json(), f, indent=2)
+
+    @staticmethod
+    def load(fn):
+        with open(fn, 'r') as f:
+            return {name: RuleProfile.from_json(data) for name, data in json.load(f).items()}
+
+    def report(self, limit=20):
+        """
+        Format the statistics of the most time-consuming rules (by self time)
+        as a table.
+
+        :param limit: Maximum number of rules to include.
+        :return: List of lines.
+        """
+        total = sum(profile.self_time for profile in self.profiles.values()) or 1.0
+        lines = ['{name:<32} {calls:>10} {cum:>10} {self:>10} {pct:>6} {size:>12} {levels:>7}'
+                 .format(name='rule', calls='calls', cum='cum (s)', self='self (s)', pct='self%', size='size', levels='levels')]
+        for name, profile in sorted(self.profiles.items(), key=lambda item: item[1].self_time, reverse=True)[:limit]:
+            lines.append('{name:<32} {calls:>10} {cum:>10.4f} {self:>10.4f} {pct:>6.1f} {size:>12} {levels:>7}'
+                         .format(name=str(name)[:32], calls=profile.calls, cum=profile.cum_time, self=profile.self_time,
+                                 pct=100 * profile.self_time / total, size=profile.size,
+                                 levels='{min}-{max}'.format(min=min(profile.levels), max=max(profile.levels))))
+        return lines
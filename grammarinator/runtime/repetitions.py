@@ -0,0 +1,157 @@
+# Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+#
+# Licensed under the BSD 3-Clause License
+# <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+# This file may not be copied, modified, or distributed except
+# according to those terms.
+
+from math import inf
+
+
+class Repetition(object):
+    """
+    Repetitions of a quantified expression among the children of a node (see
+    find_repetitions).
+    """
+
+    __slots__ = ('idx', 'min', 'max', 'spans')
+
+    def __init__(self, idx, min, max, spans):
+        """
+        :param idx: Index of the quantifier within the rule.
+        :param min: Minimum number of repetitions allowed by the quantifier.
+        :param max: Maximum number of repetitions allowed by the quantifier.
+        :param spans: List of the (start, end) child index ranges of the
+            repetitions.
+        """
+        self.idx = idx
+        self.min = min
+        self.max = max
+        self.spans = spans
+
+
+def find_repetitions(node, structure):
+    """
+    Match the children of a node against the structure of its rule (see the
+    ``_rule_structures`` table of the generated fuzzers), and find the
+    repetitions of the quantified expressions in the derivation. The
+    structure is a nested tuple of sequences (``('s', items)``), alternations
+    (``('a', sequences)``), quantifiers (``('q', idx, min, max, sequence)``),
+    references to rules (``('r', name)``) and literals (``('l', src)``).
+
+    The possible end positions of the subexpressions are memoized, and
+    quantifiers are matched iteratively, thus long runs of repetitions do not
+    recurse. If the children can be derived in several ways, the first one is
+    used (fewer repetitions first).
+
+    :param node: Node whose children are matched.
+    :param structure: Structure of the rule of the node.
+    :return: List of Repetition objects (empty if the children do not match
+        the structure, e.g., if they were modified by actions or customized
+        generators).
+    """
+    children = node.children
+    n = len(children)
+    memo = dict()
+
+    def ends(expr, pos):
+        key = (id(expr), pos)
+        result = memo.get(key)
+        if result is not None:
+            return result
+
+        kind = expr[0]
+        if kind == 'r':
+            result = {pos + 1} if pos < n and children[pos].name == expr[1] else set()
+            if expr[1] == 'EOF':
+                # Generated trees contain no EOF nodes, parsed trees do.
+                result.add(pos)
+        elif kind == 'l':
+            result = {pos + 1} if pos < n and not children[pos].children and getattr(children[pos], 'src', None) == expr[1] else set()
+        elif kind == 's':
+            result = seq_ends(expr[1], 0, pos)
+        elif kind == 'a':
+            result = set()
+            for alternative in expr[1]:
+                result |= ends(alternative, pos)
+        else:
+            result = set(quantified(expr, pos)[1])
+        memo[key] = result
+        return result
+
+    def seq_ends(items, i, pos):
+        if i == len(items):
+            return {pos}
+        key = (id(items), i, pos)
+        result = memo.get(key)
+        if result is None:
+            result = set()
+            for end in ends(items[i], pos):
+                result |= seq_ends(items, i + 1, end)
+            memo[key] = result
+        return result
+
+    def quantified(expr, pos):
+        # Breadth-first search of the states (position, number of
+        # repetitions, capped at the minimum for unbounded quantifiers) of the
+        # quantifier. The states are finite, thus even repetitions matching
+        # nothing cannot loop. Returns the parents of the reached states and a
+        # dictionary of the accepting states keyed by end position.
+        key = ('q', id(expr), pos)
+        result = memo.get(key)
+        if result is not None:
+            return result
+
+        _, _, min_cnt, max_cnt, body = expr
+        cap = min_cnt if max_cnt == inf else max_cnt
+        start = (pos, 0)
+        parents = {start: None}
+        queue = [start]
+        for state in queue:
+            at, cnt = state
+            if cnt >= max_cnt:
+                continue
+            for end in sorted(ends(body, at)):
+                new_state = (end, min(cnt + 1, cap) if max_cnt == inf else cnt + 1)
+                if new_state not in parents:
+                    parents[new_state] = state
+                    queue.append(new_state)
+        accepting = dict()
+        for state in queue:
+            if state[1] >= min_cnt and state[0] not in accepting:
+                accepting[state[0]] = state
+        result = memo[key] = (parents, accepting)
+        return result
+
+    repetitions = []
+
+    def reconstruct(expr, pos, end):
+        kind = expr[0]
+        if kind == 's':
+            items = expr[1]
+            for i, item in enumerate(items):
+                for item_end in sorted(ends(item, pos)):
+                    if end in seq_ends(items, i + 1, item_end):
+                        reconstruct(item, pos, item_end)
+                        pos = item_end
+                        break
+        elif kind == 'a':
+            for alternative in expr[1]:
+                if end in ends(alternative, pos):
+                    reconstruct(alternative, pos, end)
+                    break
+        elif kind == 'q':
+            parents, accepting = quantified(expr, pos)
+            spans = []
+            state = accepting[end]
+            while parents[state] is not None:
+                spans.append((parents[state][0], state[0]))
+                state = parents[state]
+            spans.reverse()
+            repetitions.append(Repetition(expr[1], expr[2], expr[3], spans))
+            for span_start, span_end in spans:
+                reconstruct(expr[4], span_start, span_end)
+
+    if n in ends(structure, 0):
+        reconstruct(structure, 0, n)
+    return repetitions
@@ -8,19 +8,124 @@
 from .tree import *
 
 
-def simple_space_serializer(root):
+class Serializer(object):
+    """
+    Iterative tree serializer. The tree is walked with an explicit stack
+    (thus, trees of any depth can be serialized) and the output is collected
+    as chunks (the sources of the lexer nodes and the separators) in a reusable
+    buffer that is either joined once or written to a stream in batches,
+    instead of concatenating partial results.
 
-    def _walk(node):
-        nonlocal src
-        for child in node.children:
-            _walk(child)
+    Separators are inserted after the output of the children of the nodes,
+    as decided by the separator argument:
 
-            if isinstance(node, UnparserRule):
-                src += ' '
+      - None: no separators (the output is the same as that of str()),
+      - a string: inserted after every child of every parser rule,
+      - a callable: called with a parent node and one of its children,
+        expected to return the string to be inserted after the child (or
+        None).
 
-        if isinstance(node, UnlexerRule) and node.src:
-            src += node.src
+    Instances are callable, thus they can be used everywhere where a
+    serializer function is expected (e.g., with the ``-s`` option of
+    grammarinator-generate).
+    """
 
-    src = ''
-    _walk(root)
-    return src
+    def __init__(self, separator=None, batch_size=1024):
+        """
+        :param separator: None, string or callable (see above).
+        :param batch_size: Number of chunks collected before writing them to
+            a stream (see write).
+        """
+        if isinstance(separator, str):
+            separator = ParserSeparator(separator)
+        self.separator = separator
+        self.batch_size = batch_size
+        self._batch = []
+
+    def serialize(self, root, out=None):
+        """
+        Serialize a tree into the reusable chunk buffer of the serializer.
+
+        :param root: Root of the tree to serialize.
+        :param out: Stream to write the buffer to whenever it collects
+            batch_size chunks (the buffer holds the whole output if None).
+        :return: The chunk buffer holding the (rest of the) output.
+        """
+        separator = self.separator
+        if isinstance(separator, ParserSeparator):
+            # Constant separators are decided once per parent (see below).
+            const_sep, separator = separator.sep, None
+        else:
+            const_sep = None
+        batch = self._batch
+        batch.clear()
+        emit = batch.append
+        batch_size = self.batch_size if out is not None else 0
+
+        stack = [root]
+        pop, push = stack.pop, stack.append
+        while stack:
+            node = pop()
+            if isinstance(node, str):
+                emit(node)
+                continue
+
+            children = node.children
+            if isinstance(node, UnlexerRule):
+                if not children:
+                    if node.src:
+                        emit(node.src)
+                        if batch_size and len(batch) >= batch_size:
+                            out.write(''.join(batch))
+                            batch.clear()
+                    continue
+                if node.src:
+                    push(node.src)
+
+            if separator is not None:
+                for child in reversed(children):
+                    sep = separator(node, child)
+                    if sep:
+                        push(sep)
+                    push(child)
+            elif const_sep and isinstance(node, UnparserRule):
+                for child in reversed(children):
+                    push(const_sep)
+                    push(child)
+            else:
+                stack.extend(reversed(children))
+        return batch
+
+    def write(self, root, out):
+        """
+        Write the serialized form of a tree to a text stream in batches.
+
+        :param root: Root of the tree to serialize.
+        :param out: Stream with a write method (e.g., a file or a StringIO).
+        """
+        batch = self.serialize(root, out)
+        if batch:
+            out.write(''.join(batch))
+        batch.clear()
+
+    def __call__(self, root):
+        batch = self.serialize(root)
+        result = ''.join(batch)
+        batch.clear()
+        return result
+
+
+class ParserSeparator(object):
+    """
+    Separator that inserts the same string after every child of parser rules.
+    """
+
+    def __init__(self, sep):
+        self.sep = sep
+
+    def __call__(self, parent, child):
+        return self.sep if isinstance(parent, UnparserRule) else None
+
+
+# Serializer inserting a space after every child of parser rules.
+simple_space_serializer = Serializer(separator=' ')
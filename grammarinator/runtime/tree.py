@@ -5,63 +5,95 @@
 # This file may not be copied, modified, or distributed except
 # according to those terms.
 
-import pickle
-
-from copy import copy, deepcopy
+from copy import copy
 from math import inf
+from os.path import splitext
 
 
 class Tree(object):
 
-    extension = '.grt'
+    # File extension of the saved trees, selects the format of Tree.save.
+    extension = '.grtb'
+    # Tree formats keyed by file extensions (see the tree_codec module).
+    codecs = dict()
 
     def __init__(self, root):
         self.root = root
-        self.node_dict = None
+        self._node_dict = None
+
+    @property
+    def node_dict(self):
+        """
+        Dictionary indexed by node names and containing the nodes with the
+        given name. Trees of BaseRule nodes maintain it incrementally, other
+        trees (e.g., flat trees) have to be annotated.
+        """
+        if self.root._self_indexing and '_index' in self.root.__dict__:
+            return self.root._index
+        return self._node_dict
 
     def annotate(self):
         """
-        Add a dictionary to the current object which is indexed by node names
-        and contains nodes with the given name.
-        Furthermore, it sets the level and depth fields for every node.
-        Level field tells how far a node is from root.
+        Rebuild the node dictionary and set the level and depth fields of every
+        node from scratch. Level field tells how far a node is from root.
         Depth field shows how deep the tree is below the node.
+
+        Trees of BaseRule nodes keep these up-to-date as long as they are
+        modified through the node API (add_child, insert_child, replace,
+        delete, etc.), thus annotation is only needed if the children of
+        the nodes have been manipulated directly.
+        """
+        node_dict = dict()
+        nodes = []
+        stack = [(self.root, 0)]
+        while stack:
+            node, level = stack.pop()
+            node.level = level
+            if node.name not in node_dict:
+                node_dict[node.name] = set()
+            node_dict[node.name].add(node)
+            if node._self_indexing:
+                node._index = node_dict
+            nodes.append(node)
+            stack.extend((child, level + 1) for child in node.children)
+
+        for node in reversed(nodes):
+            node.depth = max((child.depth for child in node.children), default=-1) + 1
+
+        self._node_dict = node_dict
+
+    def ensure_annotated(self):
+        """
+        Annotate the tree unless it maintains its annotation itself.
+        """
+        if not self.root._self_indexing or '_index' not in self.root.__dict__:
+            self.annotate()
+
+    @property
+    def depth(self):
+        """
+        Depth of the tree (annotated if needed).
         """
-        def _annotate(current, level):
-            """
-            :param current: The node to start annotation from (initially it's the root).
-            :param level: Level to start annotation from.
-            :return: Depth of the current node.
-            """
-            current.level = level
-            level += 1
-
-            if current.name not in self.node_dict:
-                self.node_dict[current.name] = set()
-            self.node_dict[current.name].add(current)
-
-            current.depth = 0
-            if current.children:
-                for child in current.children:
-                    child.depth = _annotate(child, level)
-                    current.depth = max(current.depth, child.depth + 1)
-
-            return current.depth
-
-        self.node_dict = dict()
-        _annotate(self.root, 0)
+        self.ensure_annotated()
+        return self.root.depth
+
+    @staticmethod
+    def codec(fn):
+        """
+        Get the codec of a tree file based on its extension.
+        """
+        ext = splitext(fn)[1]
+        if ext not in Tree.codecs:
+            raise ValueError('Unknown tree format: {ext} (known formats: {formats}).'.format(ext=ext, formats=', '.join(sorted(Tree.codecs))))
+        return Tree.codecs[ext]
 
     @staticmethod
     def load(fn):
-        with open(fn, 'rb') as f:
-            return pickle.load(f)
+        return Tree.codec(fn).load(fn)
 
     def save(self, fn, max_depth=inf):
-        self.annotate()
-
-        if self.root.depth <= max_depth:
-            with open(fn, 'wb') as f:
-                pickle.dump(self, f)
+        if self.depth <= max_depth:
+            Tree.codec(fn).save(self, fn)
 
     def print(self):
         def _walk(node):
@@ -81,17 +113,31 @@ class Tree(object):
 
 
 class BaseRule(object):
+    """
+    Base class of tree nodes. The nodes of a tree share a dictionary of the
+    nodes of the tree indexed by node names, and every node knows its level
+    (distance from the root) and depth (height of its subtree). These are
+    maintained incrementally by the methods that modify the tree (add_child,
+    insert_child, replace, delete, etc.). Nodes detached from a tree become
+    the roots of new trees (with their own node dictionaries).
+    """
 
     children = []
 
+    # Whether the nodes maintain the node dictionary and the level and depth
+    # annotations themselves.
+    _self_indexing = True
+
     def __init__(self, *, name, parent=None):
         self.name = name
-        self.parent = parent
+        self.parent = None
+        self.children = []
+        self.level = 0
+        self.depth = 0
         if parent:
             parent += self
-        self.children = []
-        self.level = None
-        self.depth = None
+        else:
+            self._index = {name: {self}}
 
     # Support for += operation.
     def __iadd__(self, child):
@@ -105,7 +151,40 @@ class BaseRule(object):
         return copy(self)
 
     def deepcopy(self):
-        return deepcopy(self)
+        """
+        Copy the subtree of the node.
+
+        :return: Root of the copy, detached from any tree.
+        """
+        node_dict = dict()
+        root = None
+        stack = [(self, None)]
+        while stack:
+            node, parent = stack.pop()
+            clone = copy(node)
+            clone.parent = parent
+            clone.children = []
+            clone.level = node.level - self.level
+            clone._index = node_dict
+            if clone.name not in node_dict:
+                node_dict[clone.name] = set()
+            node_dict[clone.name].add(clone)
+            if parent is None:
+                root = clone
+            else:
+                parent.children.append(clone)
+            stack.extend((child, clone) for child in reversed(node.children))
+        return root
+
+    def walk(self):
+        """
+        Iterate over the nodes of the subtree of the node in preorder.
+        """
+        stack = [self]
+        while stack:
+            node = stack.pop()
+            yield node
+            stack.extend(reversed(node.children))
 
     @property
     def left_sibling(self):
@@ -129,22 +208,82 @@ class BaseRule(object):
 
     @last_child.setter
     def last_child(self, node):
-        self.children.pop().parent = None
+        self.children[-1].delete()
         self.add_child(node)
 
+    def _attach(self, node):
+        # Register a node (already appended to the children list) and its
+        # subtree in the node dictionary of the tree and update the levels and
+        # depths. The node is expected to be the root of a detached tree.
+        node.parent = self
+        node_dict = self._index
+        delta = self.level + 1 - node.level
+        if not node.children:
+            # Fast path of attaching a new leaf (e.g., during generation).
+            node.level += delta
+            node._index = node_dict
+            if node.name not in node_dict:
+                node_dict[node.name] = set()
+            node_dict[node.name].add(node)
+        else:
+            for descendant in node.walk():
+                descendant.level += delta
+                descendant._index = node_dict
+                if descendant.name not in node_dict:
+                    node_dict[descendant.name] = set()
+                node_dict[descendant.name].add(descendant)
+
+        ancestor, depth = self, node.depth + 1
+        while ancestor is not None and ancestor.depth < depth:
+            ancestor.depth = depth
+            ancestor, depth = ancestor.parent, depth + 1
+
+    def _detach(self):
+        # Remove the node from its parent and make its subtree a separate tree
+        # (with its own node dictionary and levels relative to the node).
+        parent = self.parent
+        if parent is None:
+            return
+
+        parent.children.remove(self)
+        self.parent = None
+
+        old_dict, node_dict = self._index, dict()
+        delta = -self.level
+        for descendant in self.walk():
+            nodes = old_dict[descendant.name]
+            nodes.discard(descendant)
+            if not nodes:
+                del old_dict[descendant.name]
+            descendant.level += delta
+            descendant._index = node_dict
+            if descendant.name not in node_dict:
+                node_dict[descendant.name] = set()
+            node_dict[descendant.name].add(descendant)
+
+        ancestor = parent
+        while ancestor is not None:
+            depth = max((child.depth for child in ancestor.children), default=-1) + 1
+            if depth == ancestor.depth:
+                break
+            ancestor.depth = depth
+            ancestor = ancestor.parent
+
     def insert_child(self, idx, node):
         if not node:
             return
 
-        node.parent = self
+        node._detach()
         self.children.insert(idx, node)
+        self._attach(node)
 
     def add_child(self, node):
         if node is None:
             return
 
+        node._detach()
         self.children.append(node)
-        node.parent = self
+        self._attach(node)
 
     def add_children(self, nodes):
         for node in nodes:
@@ -152,18 +291,29 @@ class BaseRule(object):
 
     def replace(self, node):
         if self.parent and node is not self:
-            self.parent.children[self.parent.children.index(self)] = node
-            node.parent = self.parent
-            self.parent = None
+            parent = self.parent
+            node._detach()
+            idx = parent.children.index(self)
+            self._detach()
+            parent.children.insert(idx, node)
+            parent._attach(node)
         return node
 
     def delete(self):
-        if self.parent:
-            self.parent.children.remove(self)
-            self.parent = None
+        self._detach()
 
     def __str__(self):
-        return ''.join(str(child) for child in self.children)
+        parts = []
+        stack = [self]
+        while stack:
+            node = stack.pop()
+            if node is not self and type(node).__str__ is not BaseRule.__str__:
+                parts.append(str(node))
+            elif isinstance(node, UnlexerRule) and node.src:
+                parts.append(node.src)
+            else:
+                stack.extend(reversed(node.children))
+        return ''.join(parts)
 
     def __getattr__(self, item):
         result = [child for child in self.children if child.name == item]
@@ -183,6 +333,3 @@ class UnlexerRule(BaseRule):
     def __init__(self, *, name=None, parent=None, src=None):
         super().__init__(name=name, parent=parent)
         self.src = src
-
-    def __str__(self):
-        return self.src or super().__str__()
@@ -0,0 +1,608 @@
+# Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+#
+# Licensed under the BSD 3-Clause License
+# <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+# This file may not be copied, modified, or distributed except
+# according to those terms.
+
+import pickle
+import sys
+
+from array import array
+from bisect import bisect_left
+from math import inf
+
+from .flat_tree import FlatRule
+from .tree import Tree, UnlexerRule, UnparserRule
+
+
+class TreeCodec(object):
+    """
+    Base class of the formats that trees can be saved in and loaded from.
+    """
+
+    def load(self, fn):
+        with open(fn, 'rb') as f:
+            return self.decode(f.read())
+
+    def load_lazy(self, fn):
+        with open(fn, 'rb') as f:
+            return self.decode_lazy(f.read())
+
+    def save(self, tree, fn):
+        with open(fn, 'wb') as f:
+            self.write(tree, f)
+
+    def decode(self, data):
+        raise NotImplementedError()
+
+    def decode_lazy(self, data):
+        """
+        Decode a tree so that its nodes are only built on demand. Formats
+        that cannot do better decode the whole tree.
+
+        :return: LazyTree object.
+        """
+        return LazyTree(self.decode(data))
+
+    def encode(self, tree):
+        raise NotImplementedError()
+
+    def write(self, tree, f):
+        f.write(self.encode(tree))
+
+
+class ChunkWriter(object):
+    """
+    Minimal file-like object that collects the written chunks and joins them
+    only once at the end (cheaper than BytesIO for many small writes).
+    """
+
+    def __init__(self):
+        self.chunks = []
+        self.write = self.chunks.append
+
+    def getvalue(self):
+        return b''.join(self.chunks)
+
+
+class LazyTree(object):
+    """
+    Read-only access to the annotation of a tree where the subtrees are only
+    materialized when requested. Nodes are referred to by opaque handles
+    returned by nodes(). This base class wraps an already decoded tree, thus
+    the nodes it materializes are the nodes of that tree.
+    """
+
+    # Whether tree() and subtree() build new nodes at every call, i.e., whether
+    # the object can be reused (e.g., cached) after materialization.
+    reusable = False
+
+    def __init__(self, tree):
+        self._tree = tree
+        self._order = None
+
+    def names(self):
+        """
+        :return: Set of the names of the nodes in the tree.
+        """
+        return set(self._tree.node_dict)
+
+    def nodes(self, name):
+        """
+        :return: List of the handles of the nodes with the given name (in
+            preorder, so that random choices from the list are reproducible).
+        """
+        nodes = self._tree.node_dict.get(name, ())
+        if len(nodes) < 2:
+            return list(nodes)
+        if self._order is None:
+            self._order = dict((node, i) for i, node in enumerate(self._tree.root.walk()))
+        return sorted(nodes, key=lambda node: self._order[node])
+
+    def name(self, node):
+        return node.name
+
+    def level(self, node):
+        return node.level
+
+    def depth(self, node):
+        return node.depth
+
+    def subtree(self, node):
+        """
+        :return: Root of the subtree of the node.
+        """
+        return node
+
+    def splice(self, node, root):
+        """
+        Replace the subtree of a node with a new subtree.
+
+        :param node: Handle of the node to replace (must not be the root).
+        :param root: Root of the new subtree.
+        :return: The resulting Tree.
+        """
+        # Nodes built from objects can only be replaced with objects.
+        if isinstance(root, FlatRule) and not isinstance(node, FlatRule):
+            root = root.unflatten()
+        node.replace(root)
+        return self._tree
+
+    def tree(self):
+        return self._tree
+
+
+class EncodedLazyTree(LazyTree):
+    """
+    LazyTree on the decoded columns of a binary tree. Handles are preorder
+    node indices and only the nodes of the requested subtrees are built.
+    """
+
+    reusable = True
+
+    def __init__(self, names, strings, columns, index):
+        # pylint: disable=super-init-not-called
+        self._names = names
+        self._strings = strings
+        self._columns = columns
+        self._index = index
+        self._name_ids = dict((name, name_id) for name_id, name in enumerate(names))
+
+    def names(self):
+        return set(self._names[name_id] for name_id in self._index)
+
+    def nodes(self, name):
+        return list(self._index.get(self._name_ids.get(name, -1), ()))
+
+    def name(self, node):
+        return self._names[self._columns['kind_name'][node] >> 1]
+
+    def level(self, node):
+        return self._columns['level'][node]
+
+    def depth(self, node):
+        return self._columns['depth'][node]
+
+    def subtree(self, node):
+        return BinaryTreeCodec.build(self._names, self._strings, self._columns, self._index, node, node + self._columns['size'][node]).root
+
+    def tree(self):
+        return BinaryTreeCodec.build(self._names, self._strings, self._columns, self._index, 0, len(self._columns['kind_name']))
+
+    def splice(self, node, root):
+        """
+        Replace the subtree of a node by splicing the columns, without
+        building any nodes of the tree. Only the new subtree is encoded and
+        only the ancestors of the node are updated, the columns of the rest of
+        the tree are copied (with shifted node indices after the node).
+
+        :return: EncodedTree of the result (the object itself is unchanged).
+        """
+        names, strings, columns, index = self._names, self._strings, self._columns, self._index
+        name_ids = self._name_ids
+        new_strings = []
+
+        def name_id(name):
+            nonlocal names, name_ids
+            value_id = name_ids.get(name)
+            if value_id is None:
+                if names is self._names:
+                    names, name_ids = list(names), dict(name_ids)
+                value_id = len(names)
+                names.append(name)
+                name_ids[name] = value_id
+            return value_id
+
+        def string_id(src):
+            # Strings of the new subtree are appended to the pool (unused
+            # strings are dropped at save, see BinaryTreeCodec.write).
+            if src is None:
+                return 0
+            new_strings.append(src)
+            return len(strings) + len(new_strings) - 1
+
+        sub = BinaryTreeCodec.encode_nodes(root, name_id, string_id)
+        start, end = node, node + columns['size'][node]
+        delta = len(sub['kind_name']) - (end - start)
+        base_level = columns['level'][node]
+
+        def spliced(column, items):
+            # The new columns are 8 bytes wide, the values may not fit into
+            # the width of the original ones.
+            result = array('Q', column[:start])
+            result.extend(items)
+            result.extend(array('Q', column[end:]))
+            return result
+
+        new_columns = dict()
+        for column in ('kind_name', 'src', 'depth'):
+            new_columns[column] = spliced(columns[column], sub[column])
+        new_columns['level'] = spliced(columns['level'], [level + base_level for level in sub['level']])
+        new_columns['size'] = spliced(columns['size'], sub['size'])
+        parents = columns['parent']
+        new_columns['parent'] = result = array('Q', parents[:start])
+        result.append(parents[start])
+        result.extend(parent + start for parent in sub['parent'][1:])
+        result.extend(parent + delta if parent > end else parent for parent in parents[end:])
+
+        # Update the sizes and depths of the ancestors.
+        sizes, depths = new_columns['size'], new_columns['depth']
+        ancestor = parents[start] - 1
+        while ancestor >= 0:
+            sizes[ancestor] += delta
+            ancestor = parents[ancestor] - 1
+        ancestor, update_depth = parents[start] - 1, True
+        while ancestor >= 0 and update_depth:
+            depth, child = 0, ancestor + 1
+            while child < ancestor + sizes[ancestor]:
+                depth = max(depth, depths[child] + 1)
+                child += sizes[child]
+            update_depth = depth != depths[ancestor]
+            depths[ancestor] = depth
+            ancestor = parents[ancestor] - 1
+
+        new_index = dict()
+        for nid in set(index).union(sub['index']):
+            column = index.get(nid, ())
+            lo, hi = bisect_left(column, start), bisect_left(column, end)
+            result = array('Q', column[:lo])
+            result.extend(i + start for i in sub['index'].get(nid, ()))
+            result.extend(i + delta for i in column[hi:])
+            if result:
+                new_index[nid] = result
+
+        return EncodedTree(names, strings + new_strings if new_strings else strings, new_columns, new_index)
+
+
+class EncodedTree(Tree):
+    """
+    Tree in the decoded column form of BinaryTreeCodec (e.g., the result of
+    EncodedLazyTree.splice). Its nodes are only built at the first access of
+    its root. Until then, it can be measured (depth), serialized (str) and
+    saved in binary format directly from the columns.
+    """
+
+    def __init__(self, names, strings, columns, index):
+        # pylint: disable=super-init-not-called
+        self._encoded = (names, strings, columns, index)
+        self._root = None
+        self._node_dict = None
+
+    @property
+    def encoded(self):
+        """
+        Tuple of the name pool, the string pool, the columns and the name
+        index of the tree (None if its nodes have been built).
+        """
+        return self._encoded
+
+    @property
+    def root(self):
+        if self._encoded is not None:
+            names, strings, columns, index = self._encoded
+            self._encoded = None
+            self._root = BinaryTreeCodec.build(names, strings, columns, index, 0, len(columns['kind_name'])).root
+        return self._root
+
+    @root.setter
+    def root(self, root):
+        self._encoded = None
+        self._root = root
+
+    @property
+    def depth(self):
+        if self._encoded is not None:
+            return self._encoded[2]['depth'][0]
+        return super().depth
+
+    def ensure_annotated(self):
+        if self._encoded is None:
+            super().ensure_annotated()
+
+    def __str__(self):
+        if self._encoded is None:
+            return str(self._root)
+
+        _, strings, columns, _ = self._encoded
+        kind_names, srcs, sizes = columns['kind_name'], columns['src'], columns['size']
+        parts = []
+        i, cnt = 0, len(kind_names)
+        while i < cnt:
+            if kind_names[i] & 1 and srcs[i] and strings[srcs[i]]:
+                parts.append(strings[srcs[i]])
+                i += sizes[i]
+            else:
+                i += 1
+        return ''.join(parts)
+
+
+class PickleTreeCodec(TreeCodec):
+    """
+    Legacy format that pickles the whole object graph of the tree.
+    """
+
+    def decode(self, data):
+        tree = pickle.loads(data)
+        # Trees pickled by earlier versions do not have self-maintained
+        # annotations.
+        tree.ensure_annotated()
+        return tree
+
+    def encode(self, tree):
+        return pickle.dumps(self._object_tree(tree))
+
+    def write(self, tree, f):
+        pickle.dump(self._object_tree(tree), f)
+
+    @staticmethod
+    def _object_tree(tree):
+        return Tree(tree.root) if isinstance(tree, EncodedTree) else tree
+
+
+def write_varint(f, value):
+    out = bytearray()
+    while value >= 0x80:
+        out.append((value & 0x7f) | 0x80)
+        value >>= 7
+    out.append(value)
+    f.write(out)
+
+
+def read_varint(data, offset):
+    value, shift = 0, 0
+    while True:
+        b = data[offset]
+        offset += 1
+        value |= (b & 0x7f) << shift
+        if b < 0x80:
+            return value, offset
+        shift += 7
+
+
+class BinaryTreeCodec(TreeCodec):
+    """
+    Compact, versioned binary tree format.
+
+    Layout (all integers are unsigned varints unless stated otherwise)::
+
+        magic (b'GRTB'), version (byte)
+        name pool: count, column of name lengths (in characters), byte
+            length and UTF-8 bytes of the concatenated names
+        string pool: same as the name pool, but of the src of the nodes
+        node count
+        columns: kind/name, src, parent, size, level, depth
+        name index: count, then name id, length and column of node indices
+            of every name
+
+    Nodes are stored in preorder. The kind/name column holds ``name_id << 1 |
+    is_lexer``, the src and name ids refer to the pools (0 stands for None),
+    parent is the index of the parent node plus one (0 for the root), and size
+    is the number of nodes in the subtree of the node. Instead of encoding
+    every value as a varint, the items of a column are stored with the
+    smallest width that can hold all of its values (1, 2, 4, or 8 bytes,
+    little-endian, given in a leading byte), so that columns can be decoded
+    with array operations. Thus, neither level, depth nor the name index
+    (node_dict) have to be recomputed at load, and any subtree can be located
+    (or replaced, see EncodedLazyTree.splice) without decoding the rest of the
+    tree.
+    """
+
+    magic = b'GRTB'
+    version = 1
+
+    _typecodes = {1: 'B', 2: 'H', 4: 'I', 8: 'Q'}
+
+    def write(self, tree, f):
+        encoded = getattr(tree, 'encoded', None)
+        if encoded is not None:
+            self._write_encoded(f, *encoded)
+            return
+
+        names, name_ids = [], {None: 0}
+        strings, string_ids = [], {None: 0}
+
+        def intern(value, pool, ids):
+            value_id = ids.get(value)
+            if value_id is None:
+                value_id = len(ids)
+                pool.append(value)
+                ids[value] = value_id
+            return value_id
+
+        columns = self.encode_nodes(tree.root, lambda name: intern(name, names, name_ids), lambda src: intern(src, strings, string_ids))
+        self._write_pools(f, names, strings)
+        self._write_columns(f, columns, columns['index'])
+
+    @staticmethod
+    def encode_nodes(root, name_id, string_id):
+        """
+        Encode the subtree of a node into columns (see the class
+        documentation). Level and depth are computed relative to the root, thus
+        the tree does not have to be annotated.
+
+        :param root: Root of the subtree.
+        :param name_id: Function that maps names to name ids.
+        :param string_id: Function that maps the src of nodes to string ids.
+        :return: Dictionary of the columns (as lists) and the name index (a
+            dict of node index lists keyed by name id, under the 'index' key).
+        """
+        kind_names, srcs, parents, sizes, levels, depths = [], [], [], [], [], []
+        index = dict()
+        stack = [(root, 0)]
+        while stack:
+            node, parent = stack.pop()
+            if node is None:
+                # Marker of a finished subtree, parent holds the index of its root.
+                sizes[parent] = len(sizes) - parent
+                grand_parent = parents[parent] - 1
+                if grand_parent >= 0 and depths[grand_parent] <= depths[parent]:
+                    depths[grand_parent] = depths[parent] + 1
+                continue
+
+            node_idx = len(kind_names)
+            node_name_id = name_id(node.name)
+            is_lexer = isinstance(node, UnlexerRule)
+            kind_names.append(node_name_id << 1 | is_lexer)
+            srcs.append(string_id(node.src) if is_lexer else 0)
+            parents.append(parent)
+            sizes.append(1)
+            levels.append(levels[parent - 1] + 1 if parent else 0)
+            depths.append(0)
+            index.setdefault(node_name_id, []).append(node_idx)
+
+            stack.append((None, node_idx))
+            stack.extend((child, node_idx + 1) for child in reversed(node.children))
+
+        return {'kind_name': kind_names, 'src': srcs, 'parent': parents, 'size': sizes, 'level': levels, 'depth': depths, 'index': index}
+
+    def _write_encoded(self, f, names, strings, columns, index):
+        # Drop the strings not referred to anymore (e.g., the src of the nodes
+        # spliced out by EncodedLazyTree.splice).
+        used = sorted(set(columns['src']).difference((0, )))
+        if len(used) < len(strings) - 1:
+            string_ids = [0] * len(strings)
+            for new_id, string_id in enumerate(used, start=1):
+                string_ids[string_id] = new_id
+            columns = dict(columns)
+            columns['src'] = [string_ids[string_id] for string_id in columns['src']]
+            strings = [None] + [strings[string_id] for string_id in used]
+
+        self._write_pools(f, names[1:], strings[1:])
+        self._write_columns(f, columns, index)
+
+    def _write_pools(self, f, names, strings):
+        f.write(self.magic)
+        f.write(bytes([self.version]))
+        for pool in (names, strings):
+            blob = ''.join(pool).encode('utf-8')
+            write_varint(f, len(pool))
+            self._write_column(f, [len(value) for value in pool])
+            write_varint(f, len(blob))
+            f.write(blob)
+
+    def _write_columns(self, f, columns, index):
+        write_varint(f, len(columns['kind_name']))
+        for column in ('kind_name', 'src', 'parent', 'size', 'level', 'depth'):
+            self._write_column(f, columns[column])
+
+        write_varint(f, len(index))
+        for name_id, column in sorted(index.items()):
+            write_varint(f, name_id)
+            write_varint(f, len(column))
+            self._write_column(f, column)
+
+    def encode(self, tree):
+        f = ChunkWriter()
+        self.write(tree, f)
+        return f.getvalue()
+
+    def _write_column(self, f, column):
+        top = max(column, default=0)
+        width = 1 if top < 1 << 8 else 2 if top < 1 << 16 else 4 if top < 1 << 32 else 8
+        column = array(self._typecodes[width], column)
+        assert column.itemsize == width, 'Item size of typecode {code!r} is not {width} on this platform.'.format(code=column.typecode, width=width)
+        if sys.byteorder == 'big':
+            column.byteswap()
+        f.write(bytes([width]))
+        f.write(column.tobytes())
+
+    def _read_column(self, data, offset, count):
+        width = data[offset]
+        offset += 1
+        column = array(self._typecodes[width])
+        column.frombytes(data[offset:offset + width * count])
+        if sys.byteorder == 'big':
+            column.byteswap()
+        return column, offset + width * count
+
+    def decode_columns(self, data):
+        """
+        Decode the pools and the columns of an encoded tree without building
+        its nodes.
+
+        :param data: Bytes-like object of the encoded tree.
+        :return: Tuple of the name pool, the string pool, the columns (a dict
+            keyed by column name) and the name index (a dict of node index
+            columns keyed by name id).
+        """
+        data = memoryview(data)
+        if bytes(data[:len(self.magic)]) != self.magic:
+            raise ValueError('Not a binary tree (magic mismatch).')
+        version = data[len(self.magic)]
+        if version > self.version:
+            raise ValueError('Unsupported binary tree version: {version} (latest supported: {latest}).'.format(version=version, latest=self.version))
+        offset = len(self.magic) + 1
+
+        pools = []
+        for _ in range(2):
+            count, offset = read_varint(data, offset)
+            lengths, offset = self._read_column(data, offset, count)
+            length, offset = read_varint(data, offset)
+            blob = str(data[offset:offset + length], 'utf-8')
+            offset += length
+            pool = [None]
+            start = 0
+            for length in lengths:
+                pool.append(blob[start:start + length])
+                start += length
+            pools.append(pool)
+
+        count, offset = read_varint(data, offset)
+        columns = dict()
+        for column in ('kind_name', 'src', 'parent', 'size', 'level', 'depth'):
+            columns[column], offset = self._read_column(data, offset, count)
+
+        index = dict()
+        name_count, offset = read_varint(data, offset)
+        for _ in range(name_count):
+            name_id, offset = read_varint(data, offset)
+            count, offset = read_varint(data, offset)
+            index[name_id], offset = self._read_column(data, offset, count)
+
+        return pools[0], pools[1], columns, index
+
+    def decode(self, data):
+        names, strings, columns, index = self.decode_columns(data)
+        return self.build(names, strings, columns, index, 0, len(columns['kind_name']))
+
+    def decode_lazy(self, data):
+        return EncodedLazyTree(*self.decode_columns(data))
+
+    @staticmethod
+    def build(names, strings, columns, index, start, end):
+        """
+        Build the nodes of the [start, end) preorder range of decoded columns
+        (which is expected to be a complete subtree).
+
+        :return: Annotated Tree rooted at the start node.
+        """
+        new = object.__new__
+        nodes = []
+        append = nodes.append
+        node_dict = dict()
+        base = columns['level'][start]
+        for kind_name, src, parent, level, depth in zip(columns['kind_name'][start:end], columns['src'][start:end], columns['parent'][start:end], columns['level'][start:end], columns['depth'][start:end]):
+            parent = nodes[parent - 1 - start] if parent > start else None
+            if kind_name & 1:
+                node = new(UnlexerRule)
+                node.__dict__ = {'name': names[kind_name >> 1], 'parent': parent, 'children': [], 'level': level - base, 'depth': depth, '_index': node_dict, 'src': strings[src]}
+            else:
+                node = new(UnparserRule)
+                node.__dict__ = {'name': names[kind_name >> 1], 'parent': parent, 'children': [], 'level': level - base, 'depth': depth, '_index': node_dict}
+            if parent is not None:
+                parent.children.append(node)
+            append(node)
+
+        for name_id, column in index.items():
+            if start == 0 and end == len(columns['kind_name']):
+                name_nodes = set(nodes[i] for i in column)
+            else:
+                name_nodes = set(nodes[i - start] for i in column if start <= i < end)
+            if name_nodes:
+                node_dict[names[name_id]] = name_nodes
+        return Tree(nodes[0])
+
+
+Tree.codecs['.grt'] = PickleTreeCodec()
+Tree.codecs['.grtb'] = BinaryTreeCodec()
@@ -44,6 +44,8 @@ setup(
             'grammarinator-process = grammarinator.process:execute',
             'grammarinator-generate = grammarinator.generate:execute',
             'grammarinator-parse = grammarinator.parse:execute',
+            'grammarinator-convert = grammarinator.convert:execute',
+            'grammarinator-minimize = grammarinator.minimize:execute',
         ]
     },
     classifiers=[
@@ -0,0 +1,318 @@
+# Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+#
+# Licensed under the BSD 3-Clause License
+# <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+# This file may not be copied, modified, or distributed except
+# according to those terms.
+
+import argparse
+import glob
+import json
+import os
+import platform
+import shlex
+import shutil
+import subprocess
+import sys
+import time
+
+from run_grammars import collect_grammar_commands
+
+
+tool_dir = os.path.dirname(os.path.abspath(__file__))
+project_dir = os.path.dirname(tool_dir)
+
+# Options of the GENERATE test commands that are controlled by the benchmark.
+generate_options = {'-n': True, '-d': True, '--max-depth': True, '-j': True, '--jobs': True, '-o': True, '--out': True,
+                    '--population': True, '--random-seed': True, '--tree-format': True, '--stream': True,
+                    '--keep-trees': False, '--no-generate': False, '--no-mutate': False, '--no-recombine': False}
+
+
+def grammar_name(grammar):
+    """
+    Derive the name of a grammar from its file name (the same way as the test
+    command runners do).
+    """
+    name = os.path.basename(grammar)
+    for suffix in ['.g4', 'Lexer', 'Parser']:
+        if name.endswith(suffix):
+            name = name[:-len(suffix)]
+    return name
+
+
+def run_measured(args, cwd, env):
+    """
+    Execute a subprocess and measure its resource usage.
+
+    :param args: command line of the subprocess (as a list).
+    :param cwd: working directory of the subprocess.
+    :param env: environment of the subprocess.
+    :return: wall-clock time (in seconds) and peak resident set size (in
+        kilobytes, None if not available on the platform) of the subprocess.
+    """
+    start = time.perf_counter()
+    proc = subprocess.Popen(args, cwd=cwd, env=env, stdout=subprocess.DEVNULL)
+    if hasattr(os, 'wait4'):
+        _, status, rusage = os.wait4(proc.pid, 0)
+        proc.returncode = os.WEXITSTATUS(status) if os.WIFEXITED(status) else -1
+        # ru_maxrss is in kilobytes on Linux but in bytes on macOS.
+        rss = rusage.ru_maxrss // 1024 if sys.platform == 'darwin' else rusage.ru_maxrss
+    else:
+        proc.wait()
+        rss = None
+    elapsed = time.perf_counter() - start
+    if proc.returncode != 0:
+        raise RuntimeError('Command failed ({code}): {cmd}'.format(code=proc.returncode, cmd=' '.join(args)))
+    return elapsed, rss
+
+
+def strip_generate_options(commandline):
+    """
+    Remove the options from a GENERATE test command line that are set by the
+    benchmark itself (the number of tests, depth, jobs, output, population
+    settings, etc.), keeping the rest (generator, rule, model, serializer,
+    etc.).
+    """
+    args = shlex.split(commandline, posix=sys.platform != 'win32')
+    result = []
+    i = 0
+    while i < len(args):
+        arg = args[i]
+        option = arg.split('=', 1)[0]
+        if option in generate_options:
+            i += 2 if generate_options[option] and '=' not in arg else 1
+            continue
+        result.append(arg)
+        i += 1
+    return result
+
+
+def output_stats(directory):
+    files = [fn for fn in glob.glob(os.path.join(directory, '*')) if os.path.isfile(fn)]
+    return len(files), sum(os.path.getsize(fn) for fn in files)
+
+
+def bench_process(grammar, commands, workdir, env):
+    """
+    Measure the processing (fuzzer creation) time of a grammar by running its
+    PROCESS test commands.
+    """
+    results = []
+    for commandline in commands:
+        commandline = commandline.format(grammar=grammar_name(grammar), tmpdir=workdir)
+        args = [sys.executable, '-m', 'grammarinator.process'] + shlex.split(commandline, posix=sys.platform != 'win32')
+        elapsed, rss = run_measured(args, os.path.dirname(grammar), env)
+        results.append({'command': commandline, 'time': elapsed, 'peak_rss_kb': rss})
+    return results
+
+
+def bench_generate(grammar, generate_args, mode, depth, jobs, n, population, workdir, env):
+    """
+    Measure the throughput of one test generation mode (generation from
+    grammar, mutation or recombination) of grammarinator-generate.
+    """
+    outdir = os.path.join(workdir, 'out')
+    shutil.rmtree(outdir, ignore_errors=True)
+    os.makedirs(outdir)
+
+    args = [sys.executable, '-m', 'grammarinator.generate'] + generate_args
+    args += ['-n', str(n), '-j', str(jobs), '-o', os.path.join(outdir, 'test_%d')]
+    if depth is not None:
+        args += ['-d', str(depth)]
+    if mode == 'generate':
+        args += ['--no-mutate', '--no-recombine']
+    else:
+        args += ['--population', population, '--no-generate']
+        args += ['--no-recombine'] if mode == 'mutate' else ['--no-mutate']
+
+    elapsed, rss = run_measured(args, os.path.dirname(grammar), env)
+    tests, size = output_stats(outdir)
+    return {
+        'mode': mode,
+        'max_depth': depth,
+        'jobs': jobs,
+        'tests': tests,
+        'bytes': size,
+        'time': elapsed,
+        'tests_per_sec': tests / elapsed,
+        'bytes_per_sec': size / elapsed,
+        'peak_rss_kb': rss,
+    }
+
+
+def bench_trees(population, workdir):
+    """
+    Measure the load and save times of the trees of a population in all the
+    known tree formats.
+    """
+    from grammarinator.runtime import Tree
+
+    trees = [Tree.load(fn) for ext in Tree.codecs for fn in glob.glob(os.path.join(population, '*' + ext))]
+    results = []
+    if not trees:
+        return results
+
+    for ext in sorted(Tree.codecs):
+        tree_dir = os.path.join(workdir, 'trees' + ext)
+        shutil.rmtree(tree_dir, ignore_errors=True)
+        os.makedirs(tree_dir)
+        fns = [os.path.join(tree_dir, 'tree_{idx}{ext}'.format(idx=idx, ext=ext)) for idx in range(len(trees))]
+
+        start = time.perf_counter()
+        for tree, fn in zip(trees, fns):
+            Tree.codec(fn).save(tree, fn)
+        save_time = time.perf_counter() - start
+
+        start = time.perf_counter()
+        for fn in fns:
+            Tree.load(fn)
+        load_time = time.perf_counter() - start
+
+        results.append({
+            'format': ext,
+            'trees': len(trees),
+            'bytes': sum(os.path.getsize(fn) for fn in fns),
+            'save_time': save_time,
+            'load_time': load_time,
+        })
+    return results
+
+
+def bench_grammar(grammar, commands, args, tmpdir):
+    """
+    Run all the benchmarks of a grammar that has a Python fuzzer among its
+    test commands.
+
+    :return: the results of the grammar, or None if the grammar is not
+        suitable for benchmarking.
+    """
+    process_commands = [commandline for command, commandline in commands if command == 'PROCESS' and '--language' not in commandline]
+    generate_commands = [commandline for command, commandline in commands if command == 'GENERATE']
+    if not process_commands or not generate_commands:
+        return None
+
+    name = os.path.splitext(os.path.basename(grammar))[0]
+    workdir = os.path.join(tmpdir, name)
+    shutil.rmtree(workdir, ignore_errors=True)
+    os.makedirs(workdir)
+    env = dict(os.environ, PYTHONPATH=os.pathsep.join(filter(None, [project_dir, os.environ.get('PYTHONPATH', ''), workdir])))
+
+    print('BENCH: {grammar}'.format(grammar=grammar), file=sys.stderr)
+    result = {'grammar': os.path.relpath(grammar, project_dir), 'process': bench_process(grammar, process_commands, workdir, env), 'generate': []}
+
+    generate_args = strip_generate_options(generate_commands[0].format(grammar=grammar_name(grammar), tmpdir=workdir))
+
+    # Population of the mutation and recombination benchmarks (also measures
+    # the time of saving the generated trees).
+    population = os.path.join(workdir, 'population')
+    os.makedirs(population)
+    keep = bench_generate(grammar, generate_args + ['--population', population, '--keep-trees'], 'generate', args.depths[-1], 1, args.population_size, None, workdir, env)
+    keep['mode'] = 'populate'
+    result['generate'].append(keep)
+
+    for mode in args.modes:
+        for depth in args.depths:
+            for jobs in args.jobs:
+                try:
+                    entry = bench_generate(grammar, generate_args, mode, depth, jobs, args.n, population, workdir, env)
+                except RuntimeError as e:
+                    # E.g., the start rule cannot be generated within the depth.
+                    entry = {'mode': mode, 'max_depth': depth, 'jobs': jobs, 'error': str(e)}
+                result['generate'].append(entry)
+
+    result['trees'] = bench_trees(population, workdir)
+    return result
+
+
+def compare(results, baseline, threshold):
+    """
+    Compare the throughput of the generation benchmarks to a baseline.
+
+    :return: the list of regressions (as human-readable strings).
+    """
+    def key(grammar, entry):
+        return grammar, entry['mode'], entry['max_depth'], entry['jobs']
+
+    base = {key(r['grammar'], e): e for r in baseline['results'] for e in r['generate']}
+    regressions = []
+    for r in results['results']:
+        for entry in r['generate']:
+            old = base.get(key(r['grammar'], entry))
+            if 'error' in entry or not old or 'error' in old:
+                continue
+            if old['tests_per_sec'] > 0 and entry['tests_per_sec'] < old['tests_per_sec'] * (1 - threshold):
+                regressions.append('{grammar} {mode} (depth: {depth}, jobs: {jobs}): {new:.1f} tests/s (baseline: {old:.1f} tests/s)'
+                                   .format(grammar=r['grammar'], mode=entry['mode'], depth=entry['max_depth'], jobs=entry['jobs'],
+                                           new=entry['tests_per_sec'], old=old['tests_per_sec']))
+    return regressions
+
+
+def execute():
+    """CLI entry point."""
+    def int_list(value):
+        return [int(v) for v in value.split(',')]
+
+    parser = argparse.ArgumentParser(description='Grammarinator: Benchmark Runner',
+                                     epilog="""
+        The benchmark processes the grammars of the test suite (and the HTML
+        example) as specified by their test commands, and measures the
+        throughput of the resulting fuzzers in various settings. Results are
+        written in JSON format.
+        """)
+    parser.add_argument('grammars_dir', metavar='DIR', nargs='*',
+                        default=[os.path.join(tool_dir, 'grammars'), os.path.join(project_dir, 'examples', 'grammars')],
+                        help='directories of grammars (default: the test and example grammars).')
+    parser.add_argument('--tmpdir', metavar='DIR', default=os.path.join(os.getcwd(), 'bench'),
+                        help='temporary directory (default: %(default)s).')
+    parser.add_argument('-n', default=500, type=int, metavar='NUM',
+                        help='number of tests to create per measurement (default: %(default)d).')
+    parser.add_argument('--population-size', default=20, type=int, metavar='NUM',
+                        help='number of trees in the population of mutation and recombination (default: %(default)d).')
+    parser.add_argument('--depths', default=[5, 10, 20], type=int_list, metavar='NUM,...',
+                        help='maximum depths to measure (default: 5,10,20).')
+    parser.add_argument('--jobs', default=[1, os.cpu_count() or 1], type=int_list, metavar='NUM,...',
+                        help='job counts to measure (default: {jobs}).'.format(jobs=','.join(str(jobs) for jobs in sorted({1, os.cpu_count() or 1}))))
+    parser.add_argument('--modes', default=['generate', 'mutate', 'recombine'], type=lambda value: value.split(','), metavar='MODE,...',
+                        help='test creation modes to measure (default: generate,mutate,recombine).')
+    parser.add_argument('-o', '--out', metavar='FILE',
+                        help='file to write the results to (default: standard output).')
+    parser.add_argument('--baseline', metavar='FILE',
+                        help='results of an earlier run to compare the generation throughput to (exit code is 1 on regression).')
+    parser.add_argument('--threshold', default=0.2, type=float, metavar='NUM',
+                        help='relative throughput loss considered to be a regression (default: %(default)f).')
+    args = parser.parse_args()
+    args.jobs = sorted(set(args.jobs))
+
+    os.makedirs(args.tmpdir, exist_ok=True)
+
+    results = {
+        'python': platform.python_version(),
+        'platform': platform.platform(),
+        'cpu_count': os.cpu_count(),
+        'settings': {'n': args.n, 'population_size': args.population_size, 'depths': args.depths, 'jobs': args.jobs, 'modes': args.modes},
+        'results': [],
+    }
+    for grammars_dir in args.grammars_dir:
+        for grammar, commands in sorted(collect_grammar_commands(grammars_dir)):
+            result = bench_grammar(grammar, commands, args, os.path.abspath(args.tmpdir))
+            if result:
+                results['results'].append(result)
+
+    if args.out:
+        with open(args.out, 'w') as f:
+            json.dump(results, f, indent=2)
+    else:
+        json.dump(results, sys.stdout, indent=2)
+        print()
+
+    if args.baseline:
+        with open(args.baseline, 'r') as f:
+            regressions = compare(results, json.load(f), args.threshold)
+        for regression in regressions:
+            print('REGRESSION: {regression}'.format(regression=regression), file=sys.stderr)
+        if regressions:
+            sys.exit(1)
+
+
+if __name__ == '__main__':
+    execute()
@@ -0,0 +1,168 @@
+# Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+#
+# Licensed under the BSD 3-Clause License
+# <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+# This file may not be copied, modified, or distributed except
+# according to those terms.
+
+import glob
+import json
+import logging
+import re
+import sys
+
+from argparse import ArgumentParser
+
+from grammarinator.runtime import Tree, UnlexerRule
+
+logger = logging.getLogger('grammarinator')
+
+
+def expand(pattern):
+    """
+    List the files matching a file name pattern (``%d`` matches any index),
+    sorted by name.
+    """
+    return sorted(glob.glob(pattern.replace('%d', '*')))
+
+
+def check_size(args):
+    errors = 0
+    for fn in args.files:
+        with open(fn, 'rb') as f:
+            size = len(f.read())
+        if not args.min <= size <= args.max:
+            logger.error('Size of {fn} is {size}, expected [{min}, {max}]'.format(fn=fn, size=size, min=args.min, max=args.max))
+            errors += 1
+    return errors
+
+
+def check_same(args):
+    errors = 0
+    for fn_1, fn_2 in zip(args.files, args.other):
+        with open(fn_1, 'rb') as f_1, open(fn_2, 'rb') as f_2:
+            if f_1.read() != f_2.read():
+                logger.error('{fn_1} and {fn_2} differ'.format(fn_1=fn_1, fn_2=fn_2))
+                errors += 1
+    if len(args.files) != len(args.other):
+        logger.error('Number of files differ: {cnt_1} and {cnt_2}'.format(cnt_1=len(args.files), cnt_2=len(args.other)))
+        errors += 1
+    return errors
+
+
+def check_match(args):
+    errors = 0
+    pattern = re.compile(args.pattern, re.DOTALL)
+    for fn in args.files:
+        with open(fn, 'r', encoding='utf-8') as f:
+            if not pattern.fullmatch(f.read()):
+                logger.error('{fn} does not match {pattern}'.format(fn=fn, pattern=args.pattern))
+                errors += 1
+    return errors
+
+
+def tree_nodes(tree):
+    """
+    List the kinds, names, sources and numbers of children of the nodes of a
+    tree in preorder (two trees are the same if their lists are equal).
+    """
+    nodes = []
+    for node in tree.root.walk():
+        is_lexer = isinstance(node, UnlexerRule)
+        nodes.append((is_lexer, node.name, node.src if is_lexer else None, len(node.children)))
+    return nodes
+
+
+def check_trees(args):
+    errors = 0
+    for fn_1, fn_2 in zip(args.files, args.other):
+        if tree_nodes(Tree.load(fn_1)) != tree_nodes(Tree.load(fn_2)):
+            logger.error('Trees of {fn_1} and {fn_2} differ'.format(fn_1=fn_1, fn_2=fn_2))
+            errors += 1
+    if len(args.files) != len(args.other):
+        logger.error('Number of files differ: {cnt_1} and {cnt_2}'.format(cnt_1=len(args.files), cnt_2=len(args.other)))
+        errors += 1
+    return errors
+
+
+def check_profile(args):
+    errors = 0
+    for fn in args.files:
+        with open(fn, 'r') as f:
+            calls = json.load(f).get(args.rule, {}).get('calls', 0)
+        if calls != args.calls:
+            logger.error('{rule} is called {calls} times in {fn}, expected {expected}'.format(rule=args.rule, calls=calls, fn=fn, expected=args.calls))
+            errors += 1
+    return errors
+
+
+def check_count(args):
+    if not args.min <= len(args.files) <= args.max:
+        logger.error('Found {cnt} files, expected [{min}, {max}]'.format(cnt=len(args.files), min=args.min, max=args.max))
+        return 1
+    return 0
+
+
+def execute():
+    parser = ArgumentParser(description='Grammarinator: Test Output Checker')
+    subparsers = parser.add_subparsers(dest='check')
+    subparsers.required = True
+
+    size_parser = subparsers.add_parser('size', help='check whether the sizes (in bytes) of the files are in the given range.')
+    size_parser.add_argument('--min', default=0, type=int, metavar='NUM',
+                             help='minimum size (default: %(default)d).')
+    size_parser.add_argument('--max', default=sys.maxsize, type=int, metavar='NUM',
+                             help='maximum size (default: unlimited).')
+    size_parser.set_defaults(fn=check_size)
+
+    same_parser = subparsers.add_parser('same', help='check whether two sets of files (paired by name order) have the same contents.')
+    same_parser.set_defaults(fn=check_same)
+
+    match_parser = subparsers.add_parser('match', help='check whether the contents of the files match a regular expression.')
+    match_parser.add_argument('--pattern', required=True, metavar='REGEX',
+                              help='regular expression to match the whole contents against.')
+    match_parser.set_defaults(fn=check_match)
+
+    trees_parser = subparsers.add_parser('trees', help='check whether two sets of tree files (paired by name order, of any tree format) contain the same trees.')
+    trees_parser.set_defaults(fn=check_trees)
+
+    profile_parser = subparsers.add_parser('profile', help='check the number of calls of a rule in generation profiles (see the --profile option of generator).')
+    profile_parser.add_argument('--rule', required=True, metavar='NAME',
+                                help='name of the rule.')
+    profile_parser.add_argument('--calls', required=True, type=int, metavar='NUM',
+                                help='expected number of calls.')
+    profile_parser.set_defaults(fn=check_profile)
+
+    count_parser = subparsers.add_parser('count', help='check whether the number of files is in the given range.')
+    count_parser.add_argument('--min', default=1, type=int, metavar='NUM',
+                              help='minimum number of files (default: %(default)d).')
+    count_parser.add_argument('--max', default=sys.maxsize, type=int, metavar='NUM',
+                              help='maximum number of files (default: unlimited).')
+    count_parser.set_defaults(fn=check_count)
+
+    for subparser in (size_parser, same_parser, match_parser, trees_parser, profile_parser, count_parser):
+        subparser.add_argument('files', metavar='FILE',
+                               help='file name pattern (%%d matches any index).')
+        subparser.add_argument('--log-level', default='INFO', metavar='LEVEL',
+                               help='verbosity level of diagnostic messages (default: %(default)s).')
+    for subparser in (same_parser, trees_parser):
+        subparser.add_argument('other', metavar='FILE',
+                               help='file name pattern of the other set.')
+    args = parser.parse_args()
+
+    logging.basicConfig(format='%(message)s')
+    logger.setLevel(args.log_level)
+
+    args.files = expand(args.files)
+    if hasattr(args, 'other'):
+        args.other = expand(args.other)
+    if not args.files and args.check != 'count':
+        logger.error('No file found')
+        sys.exit(1)
+
+    if args.fn(args) > 0:
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    execute()
@@ -0,0 +1,82 @@
+# Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+#
+# Licensed under the BSD 3-Clause License
+# <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+# This file may not be copied, modified, or distributed except
+# according to those terms.
+
+import json
+import logging
+import re
+import sys
+
+from argparse import ArgumentParser
+
+from grammarinator.generate import Generator
+
+logger = logging.getLogger('grammarinator')
+
+
+def learn(args):
+    """
+    Generate tests in memory and give feedback about them, as an in-process
+    harness would (the tests matching the pattern count as new coverage).
+    The learned weights are saved at exit.
+    """
+    with Generator(generator=args.generator, rule=args.rule, out_format=None, model='grammarinator.model.FeedbackModel',
+                   max_depth=args.max_depth, random_seed=args.random_seed, model_weights=args.model_weights) as generator:
+        for index in range(args.n):
+            data, _ = generator.create_new_test_data(index)
+            generator.feedback(re.search(args.reward, data.decode('utf-8')) is not None, exec_time=len(data))
+
+
+def reload(args):
+    """
+    Load the saved weights into a new generator, generate a test without
+    feedback, and save the weights again at exit.
+    """
+    with Generator(generator=args.generator, rule=args.rule, out_format=None, model='grammarinator.model.FeedbackModel',
+                   max_depth=args.max_depth, random_seed=args.random_seed, model_weights=args.model_weights) as generator:
+        generator.create_new_test_data(0)
+
+
+def execute():
+    parser = ArgumentParser(description='Grammarinator: Feedback Harness')
+    parser.add_argument('generator', metavar='NAME',
+                        help='reference to the generator created by grammarinator-process (in package.module.class format).')
+    parser.add_argument('-r', '--rule', metavar='NAME',
+                        help='name of the rule to start generation from (default: first parser rule).')
+    parser.add_argument('-d', '--max-depth', default=10, type=int, metavar='NUM',
+                        help='maximum recursion depth during generation (default: %(default)d).')
+    parser.add_argument('-n', default=20, type=int, metavar='NUM',
+                        help='number of tests to learn from (default: %(default)d).')
+    parser.add_argument('--reward', required=True, metavar='REGEX',
+                        help='regular expression of the tests that count as new coverage.')
+    parser.add_argument('--model-weights', required=True, metavar='FILE',
+                        help='file to save the learned weights to.')
+    parser.add_argument('--random-seed', default=1, type=int, metavar='NUM',
+                        help='master seed of the random number generators (default: %(default)d).')
+    parser.add_argument('--log-level', default='INFO', metavar='LEVEL',
+                        help='verbosity level of diagnostic messages (default: %(default)s).')
+    args = parser.parse_args()
+
+    logging.basicConfig(format='%(message)s')
+    logger.setLevel(args.log_level)
+
+    learn(args)
+    with open(args.model_weights, 'rb') as f:
+        learned = f.read()
+    if not json.loads(learned.decode('utf-8')).get('choice'):
+        logger.error('No weights learned into {fn}'.format(fn=args.model_weights))
+        sys.exit(1)
+
+    reload(args)
+    with open(args.model_weights, 'rb') as f:
+        reloaded = f.read()
+    if reloaded != learned:
+        logger.error('Weights of {fn} changed when reloaded'.format(fn=args.model_weights))
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    execute()
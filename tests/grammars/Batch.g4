@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+ *
+ * Licensed under the BSD 3-Clause License
+ * <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+ * This file may not be copied, modified, or distributed except
+ * according to those terms.
+ */
+
+/*
+ * This test checks whether multiple fuzzers can be created in one run (with
+ * the `--batch` CLI option), both from combined and from separate parser and
+ * lexer grammars, in parallel (`-j N`), and whether the processing works when
+ * the meta-parser and the grammar graphs are cached (`--cache-dir` CLI
+ * option). The processing is run twice to use the cache the second time.
+ */
+
+// TEST-PROCESS: {grammar}.g4 Hello.g4 SeparateParser.g4 SeparateLexer.g4 -o {tmpdir} --batch -j 2 --cache-dir {tmpdir}/cache
+// TEST-PROCESS: {grammar}.g4 Hello.g4 SeparateParser.g4 SeparateLexer.g4 -o {tmpdir} --batch -j 2 --cache-dir {tmpdir}/cache
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -n 5 -o {tmpdir}/{grammar}%d.txt
+// TEST-GENERATE: HelloGenerator.HelloGenerator -r start -n 5 -o {tmpdir}/Hello%d.txt
+// TEST-GENERATE: SeparateGenerator.SeparateGenerator -r start -n 5 -o {tmpdir}/Separate%d.txt
+// TEST-ANTLR: {grammar}.g4 -o {tmpdir}
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}%d.txt
+
+grammar Batch;
+
+start
+  : item (',' item)*
+  ;
+
+item
+  : ID
+  | '(' start ')'
+  ;
+
+ID
+  : [a-z]+
+  ;
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+ *
+ * Licensed under the BSD 3-Clause License
+ * <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+ * This file may not be copied, modified, or distributed except
+ * according to those terms.
+ */
+
+/*
+ * This test checks whether the generations aborted because of exceeding the
+ * node, byte or time budgets of the tests (`--max-nodes`, `--max-bytes` and
+ * `--max-time` CLI options of generator) are retried and the resulting tests
+ * are syntactically correct, even without a depth limit. The time budget is
+ * tested both combined with a node budget and alone (with a few milliseconds,
+ * so that the deep generations are aborted by the clock).
+ */
+
+// TEST-PROCESS: {grammar}.g4 -o {tmpdir}
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -j 1 -n 5 --max-nodes 500 -o {tmpdir}/{grammar}N%d.txt
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -j 2 -n 5 --max-bytes 200 -o {tmpdir}/{grammar}B%d.txt
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -j 1 -n 5 --max-nodes 5000 --max-time 0.5 -o {tmpdir}/{grammar}NT%d.txt
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -j 1 -n 5 --max-time 0.002 -o {tmpdir}/{grammar}T%d.txt
+// TEST-ANTLR: {grammar}.g4 -o {tmpdir}
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}N%d.txt
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}B%d.txt
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}NT%d.txt
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}T%d.txt
+
+grammar Budgets;
+
+start
+  : expr EOF
+  ;
+
+expr
+  : expr ('+' | '*') expr
+  | '(' expr ')'
+  | NUM
+  ;
+
+NUM
+  : [0-9]+
+  ;
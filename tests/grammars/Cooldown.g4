@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+ *
+ * Licensed under the BSD 3-Clause License
+ * <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+ * This file may not be copied, modified, or distributed except
+ * according to those terms.
+ */
+
+/*
+ * This test checks whether the worker processes of generator can cool down
+ * the alternatives together (`--cooldown` CLI option with `-j N`), both with
+ * a strong and with a weak cool-down factor, and whether the shared counters
+ * still let the generator create syntactically correct tests.
+ */
+
+// TEST-PROCESS: {grammar}.g4 -o {tmpdir}
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -d 8 -j 2 -n 20 --cooldown 0.1 -o {tmpdir}/{grammar}S%d.txt
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -d 8 -j 2 -n 20 --cooldown 0.9 -o {tmpdir}/{grammar}W%d.txt
+// TEST-CHECK: match --pattern "[a-d]+(;[a-d]+)*" {tmpdir}/{grammar}S%d.txt
+// TEST-CHECK: match --pattern "[a-d]+(;[a-d]+)*" {tmpdir}/{grammar}W%d.txt
+// TEST-ANTLR: {grammar}.g4 -o {tmpdir}
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}S%d.txt
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}W%d.txt
+
+grammar Cooldown;
+
+start
+  : word (';' word)* EOF
+  ;
+
+word
+  : letter+
+  ;
+
+letter
+  : 'a'
+  | 'b'
+  | 'c'
+  | 'd'
+  ;
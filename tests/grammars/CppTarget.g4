@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+ *
+ * Licensed under the BSD 3-Clause License
+ * <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+ * This file may not be copied, modified, or distributed except
+ * according to those terms.
+ */
+
+/*
+ * This test checks whether the C++ target of the processor can handle
+ * alternations, quantifiers, charsets, imaginary tokens, EOF and literals
+ * with escapes, and whether the generated code compiles without warnings.
+ */
+
+// TEST-PROCESS: {grammar}.g4 --language cpp --no-actions -o {tmpdir}
+// TEST-CXX: -std=c++11 -Wall -Wextra -Werror -I{tmpdir} {tmpdir}/{grammar}Generator.cpp -o {tmpdir}/{grammar}Generator
+// TEST-ANTLR: {grammar}.g4 -o {tmpdir}
+
+grammar CppTarget;
+
+tokens { IMAG }
+
+start
+  : greeting (' ' NAME)* EOF
+  ;
+
+greeting
+  : 'hello'
+  | 'hi'
+  | '"quoted"'
+  | 'back\\slash'
+  | 'new\nline'
+  | '\u00e9t\u{E9}'
+  ;
+
+NAME
+  : [a-z] ~[ ]*
+  ;
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+ *
+ * Licensed under the BSD 3-Clause License
+ * <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+ * This file may not be copied, modified, or distributed except
+ * according to those terms.
+ */
+
+/*
+ * This test checks whether the rule-specific handlers (`enter_<name>` and
+ * `exit_<name>` methods) of dispatching listeners (`-l` CLI option of
+ * generator) are called, also if they are inherited, in single and in
+ * multiple processes, and whether the rules without handlers are skipped.
+ */
+
+// TEST-PROCESS: {grammar}.g4 -o {tmpdir}
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -l CustomListener.MarkingListener -j 1 -n 5 -o {tmpdir}/{grammar}S%d.txt
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -l CustomListener.MarkingSubclassListener -j 2 -n 5 -o {tmpdir}/{grammar}M%d.txt
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -l CustomListener.SkippingListener -j 1 -n 5 -o {tmpdir}/{grammar}K%d.txt
+// TEST-CHECK: match --pattern "[a-z]+!( [a-z]+!)*" {tmpdir}/{grammar}S%d.txt
+// TEST-CHECK: match --pattern "[a-z]+!( [a-z]+!)*" {tmpdir}/{grammar}M%d.txt
+// TEST-CHECK: match --pattern "[a-z]+!( [a-z]+!)*" {tmpdir}/{grammar}K%d.txt
+// TEST-ANTLR: {grammar}.g4 -o {tmpdir}
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}S%d.txt
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}M%d.txt
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}K%d.txt
+
+grammar CustomListener;
+
+start
+  : word (' ' word)* EOF
+  ;
+
+word
+  : WORD '!'?
+  ;
+
+WORD
+  : [a-z]+
+  ;
@@ -0,0 +1,45 @@
+# Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+#
+# Licensed under the BSD 3-Clause License
+# <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+# This file may not be copied, modified, or distributed except
+# according to those terms.
+
+# These custom listeners are used by CustomListener.g4
+
+from grammarinator.runtime import DispatchingListener, UnlexerRule
+
+
+class MarkingListener(DispatchingListener):
+
+    # Only the words are marked, the handlers of the other rules are not
+    # defined.
+    def exit_word(self, node):
+        if node.last_child.name is not None or node.last_child.src != '!':
+            node.add_child(UnlexerRule(src='!'))
+
+
+class MarkingSubclassListener(MarkingListener):
+
+    # Handlers are inherited, and both the enter and the exit handlers are
+    # dispatched.
+    def enter_start(self, node):
+        self.words = 0
+
+    def enter_word(self, node):
+        self.words += 1
+
+    def exit_start(self, node):
+        assert self.words > 0
+
+
+class SkippingListener(MarkingListener):
+
+    # The generator gets no handlers for the rules that the listener defines
+    # no enter_<rule> or exit_<rule> methods for, thus it skips them.
+    def __init__(self):
+        super().__init__()
+        assert self.enter_handler('start') is None
+        assert self.exit_handler('start') is None
+        assert self.enter_handler('word') is None
+        assert self.exit_handler('word') is not None
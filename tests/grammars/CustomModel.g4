@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+ *
+ * Licensed under the BSD 3-Clause License
+ * <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+ * This file may not be copied, modified, or distributed except
+ * according to those terms.
+ */
+
+/*
+ * This test checks whether custom models (`--model` CLI option of generator)
+ * derived from DefaultModel and DispatchingModel with their own constructors
+ * (without an rng parameter, or without calling the constructor of the base
+ * class) can be used, also with a master seed (`--random-seed`).
+ *
+ * Note:
+ *  - Because this test generates multiple outputs files, it exercises both
+ *    single-process (`-j 1`) and multi-process (`-j N`) modes of generator.
+ */
+
+// TEST-PROCESS: {grammar}.g4 -o {tmpdir}
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -m CustomModel.CustomModel -j 1 -n 5 -o {tmpdir}/{grammar}S%d.txt
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -m CustomModel.CustomModel -j 2 -n 5 --random-seed 1 -o {tmpdir}/{grammar}M%d.txt
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -m CustomModel.CustomDispatchingModel -j 1 -n 5 --random-seed 1 -o {tmpdir}/{grammar}D%d.txt
+// TEST-ANTLR: {grammar}.g4 -o {tmpdir}
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}S%d.txt
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}M%d.txt
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}D%d.txt
+
+grammar CustomModel;
+
+start
+  : item (',' item)* EOF
+  ;
+
+item
+  : 'a'
+  | 'b'
+  ;
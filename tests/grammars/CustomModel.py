@@ -0,0 +1,32 @@
+# Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+#
+# Licensed under the BSD 3-Clause License
+# <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+# This file may not be copied, modified, or distributed except
+# according to those terms.
+
+# These custom models are used by CustomModel.g4
+
+from grammarinator.model import DefaultModel, DispatchingModel
+
+
+class CustomModel(DefaultModel):
+
+    # The constructor neither accepts an rng argument nor calls the base
+    # class constructor.
+    def __init__(self):
+        self.choices = 0
+
+    def choice(self, node, idx, choices):
+        self.choices += 1
+        return super().choice(node, idx, choices)
+
+
+class CustomDispatchingModel(DispatchingModel):
+
+    def __init__(self):
+        super().__init__()
+
+    def choice_item(self, node, idx, choices):
+        # Always choose the last enabled alternative of item.
+        return max(i for i, w in enumerate(choices) if w > 0)
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+ *
+ * Licensed under the BSD 3-Clause License
+ * <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+ * This file may not be copied, modified, or distributed except
+ * according to those terms.
+ */
+
+/*
+ * This test checks whether the structural edits of the trees of a population
+ * (duplication, deletion and swapping of repetitions, hoisting of subtrees,
+ * replacement of tokens) create syntactically correct tests, when all the
+ * other strategies are disabled (`--no-generate`, `--no-mutate` and
+ * `--no-recombine` CLI options of generator). The pair of IDs is not a
+ * repetition of a quantifier, thus it must not be edited as such.
+ */
+
+// TEST-PROCESS: {grammar}.g4 -o {tmpdir}
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -d 10 -j 1 -n 10 --population {tmpdir}/{grammar}.grdb --keep-trees --no-mutate --no-recombine --no-edit -o {tmpdir}/{grammar}G%d.txt
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -d 10 -j 1 -n 20 --population {tmpdir}/{grammar}.grdb --no-generate --no-mutate --no-recombine -o {tmpdir}/{grammar}E%d.txt
+// TEST-ANTLR: {grammar}.g4 -o {tmpdir}
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}G%d.txt
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}E%d.txt
+
+grammar Edits;
+
+start
+  : list EOF
+  ;
+
+list
+  : item (',' item)*
+  ;
+
+item
+  : ID
+  | '[' list? ']'
+  | '<' ID ID '>'
+  ;
+
+ID
+  : [a-z]+
+  ;
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+ *
+ * Licensed under the BSD 3-Clause License
+ * <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+ * This file may not be copied, modified, or distributed except
+ * according to those terms.
+ */
+
+/*
+ * This test checks whether the weights learned by the feedback model from an
+ * in-process harness are saved and reloaded unchanged (`model_weights` of
+ * Generator), and whether the generator can create syntactically correct
+ * tests with the learned weights (`--model-weights` CLI option of
+ * generator).
+ */
+
+// TEST-PROCESS: {grammar}.g4 -o {tmpdir}
+// TEST-FEEDBACK: {grammar}Generator.{grammar}Generator -r start -n 30 --reward "a" --model-weights {tmpdir}/{grammar}.json
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -d 10 -j 1 -n 5 --model grammarinator.model.FeedbackModel --model-weights {tmpdir}/{grammar}.json -o {tmpdir}/{grammar}%d.txt
+// TEST-ANTLR: {grammar}.g4 -o {tmpdir}
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}%d.txt
+
+grammar Feedback;
+
+start
+  : item (',' item)* EOF
+  ;
+
+item
+  : 'a'
+  | 'b'
+  | '[' item ']'
+  ;
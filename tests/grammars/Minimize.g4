@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+ *
+ * Licensed under the BSD 3-Clause License
+ * <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+ * This file may not be copied, modified, or distributed except
+ * according to those terms.
+ */
+
+/*
+ * This test checks whether a small population (with many duplicates, due to
+ * the small depth limit) can be deduplicated and minimized by minimizer into
+ * population databases and directories, in single and in multiple
+ * processes, also if the trees were saved as flat trees (`--flat-tree` CLI
+ * option of generator), and whether the selected trees can be recombined
+ * into syntactically correct tests.
+ */
+
+// TEST-PROCESS: {grammar}.g4 -o {tmpdir}
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -d 4 -j 1 -n 30 --population {tmpdir}/{grammar}.grdb --keep-trees --no-mutate --no-recombine --no-edit -o {tmpdir}/{grammar}G%d.txt
+// TEST-MINIMIZE: {tmpdir}/{grammar}.grdb -o {tmpdir}/{grammar}D.grdb
+// TEST-MINIMIZE: {tmpdir}/{grammar}.grdb -o {tmpdir}/{grammar}M.grdb --minimize -j 2
+// TEST-MINIMIZE: {tmpdir}/{grammar}.grdb -o {tmpdir}/min --max-size 5
+// TEST-CHECK: count --min 1 --max 5 {tmpdir}/min/%d.grtb
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -d 4 -j 1 -n 30 --flat-tree --population {tmpdir}/flat --keep-trees --tree-format grt --no-mutate --no-recombine --no-edit -o {tmpdir}/{grammar}F%d.txt
+// TEST-MINIMIZE: {tmpdir}/flat -o {tmpdir}/flatmin --minimize
+// TEST-CHECK: count --min 2 {tmpdir}/flatmin/%d.grtb
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -d 4 -j 1 -n 10 --population {tmpdir}/{grammar}M.grdb --no-generate --no-mutate --no-edit -o {tmpdir}/{grammar}R%d.txt
+// TEST-ANTLR: {grammar}.g4 -o {tmpdir}
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}R%d.txt
+
+grammar Minimize;
+
+start
+  : list EOF
+  ;
+
+list
+  : item (',' item)*
+  ;
+
+item
+  : 'a'
+  | 'b'
+  | '(' list ')'
+  ;
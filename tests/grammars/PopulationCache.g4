@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+ *
+ * Licensed under the BSD 3-Clause License
+ * <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+ * This file may not be copied, modified, or distributed except
+ * according to those terms.
+ */
+
+/*
+ * This test checks whether mutation and recombination create syntactically
+ * correct tests with the population cache disabled, with a cache smaller
+ * than the population, and with a cache filled before the worker processes
+ * are started (`--population-cache` and `--population-preload` CLI options
+ * of generator).
+ */
+
+// TEST-PROCESS: {grammar}.g4 -o {tmpdir}
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -d 10 -j 1 -n 20 --population {tmpdir}/{grammar}.grdb --keep-trees --no-mutate --no-recombine --no-edit -o {tmpdir}/{grammar}G%d.txt
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -d 10 -j 1 -n 20 --population {tmpdir}/{grammar}.grdb --population-cache 0 --no-generate --no-edit -o {tmpdir}/{grammar}N%d.txt
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -d 10 -j 2 -n 20 --population {tmpdir}/{grammar}.grdb --population-cache 5 --no-generate --no-edit -o {tmpdir}/{grammar}S%d.txt
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -d 10 -j 2 -n 20 --population {tmpdir}/{grammar}.grdb --population-cache 5 --population-preload --no-generate --no-edit -o {tmpdir}/{grammar}P%d.txt
+// TEST-ANTLR: {grammar}.g4 -o {tmpdir}
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}N%d.txt
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}S%d.txt
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}P%d.txt
+
+grammar PopulationCache;
+
+start
+  : row (NL row)* EOF
+  ;
+
+row
+  : cell (',' cell)*
+  ;
+
+cell
+  : NUM
+  | '"' ID '"'
+  | '[' row ']'
+  ;
+
+ID
+  : [a-z]+
+  ;
+
+NUM
+  : [0-9]+
+  ;
+
+NL
+  : '\n'
+  ;
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+ *
+ * Licensed under the BSD 3-Clause License
+ * <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+ * This file may not be copied, modified, or distributed except
+ * according to those terms.
+ */
+
+/*
+ * This test checks whether the worker processes of generator can add trees
+ * to a new population database (a population file with the `.grdb`
+ * extension) concurrently, whether a directory population can be collected
+ * into a database by converter, and whether the trees of the databases can
+ * be mutated and recombined into syntactically correct tests.
+ */
+
+// TEST-PROCESS: {grammar}.g4 -o {tmpdir}
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -d 10 -j 2 -n 20 --population {tmpdir}/{grammar}.grdb --keep-trees --no-mutate --no-recombine --no-edit -o {tmpdir}/{grammar}G%d.txt
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -d 10 -j 2 -n 20 --population {tmpdir}/{grammar}.grdb --no-generate --no-edit -o {tmpdir}/{grammar}M%d.txt
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -d 10 -j 1 -n 10 --population {tmpdir}/pop --keep-trees --no-mutate --no-recombine --no-edit -o {tmpdir}/{grammar}D%d.txt
+// TEST-CONVERT: {tmpdir}/pop -o {tmpdir}/{grammar}C.grdb
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -d 10 -j 1 -n 20 --population {tmpdir}/{grammar}C.grdb --no-generate --no-edit -o {tmpdir}/{grammar}C%d.txt
+// TEST-ANTLR: {grammar}.g4 -o {tmpdir}
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}G%d.txt
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}M%d.txt
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}C%d.txt
+
+grammar PopulationDB;
+
+start
+  : statement+ EOF
+  ;
+
+statement
+  : ID '=' expr ';'
+  | '{' statement* '}'
+  ;
+
+expr
+  : ID
+  | NUM
+  | '(' expr ('+' expr)* ')'
+  ;
+
+ID
+  : [a-z]+
+  ;
+
+NUM
+  : [0-9]+
+  ;
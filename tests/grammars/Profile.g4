@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+ *
+ * Licensed under the BSD 3-Clause License
+ * <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+ * This file may not be copied, modified, or distributed except
+ * according to those terms.
+ */
+
+/*
+ * This test checks whether the per-rule profile of generation is saved
+ * (`--profile` CLI option of generator), both by a single process and merged
+ * from worker processes, and whether the profiled generation still creates
+ * syntactically correct tests.
+ */
+
+// TEST-PROCESS: {grammar}.g4 -o {tmpdir}
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -d 10 -j 1 -n 5 --profile {tmpdir}/{grammar}S.json -o {tmpdir}/{grammar}S%d.txt
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -d 10 -j 2 -n 5 --profile {tmpdir}/{grammar}M.json -o {tmpdir}/{grammar}M%d.txt
+// TEST-CHECK: profile --rule start --calls 5 {tmpdir}/{grammar}S.json
+// TEST-CHECK: profile --rule start --calls 5 {tmpdir}/{grammar}M.json
+// TEST-ANTLR: {grammar}.g4 -o {tmpdir}
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}S%d.txt
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}M%d.txt
+
+grammar Profile;
+
+start
+  : sum EOF
+  ;
+
+sum
+  : product ('+' product)*
+  ;
+
+product
+  : atom ('*' atom)*
+  ;
+
+atom
+  : NUM
+  | '(' sum ')'
+  ;
+
+NUM
+  : [0-9]+
+  ;
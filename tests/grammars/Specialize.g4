@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+ *
+ * Licensed under the BSD 3-Clause License
+ * <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+ * This file may not be copied, modified, or distributed except
+ * according to those terms.
+ */
+
+/*
+ * This test checks whether the rules of fuzzers specialized by the remaining
+ * depth (`--specialize` CLI option of processor) generate syntactically
+ * correct tests, both within and beyond the remaining depth that is enough
+ * for the bounded (non-recursive) rules.
+ *
+ * Note:
+ *  - Because this test generates multiple outputs files, it exercises both
+ *    single-process (`-j 1`) and multi-process (`-j N`) modes of generator.
+ */
+
+// TEST-PROCESS: {grammar}.g4 -o {tmpdir} --specialize
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -j 1 -n 5 -d 4 -o {tmpdir}/{grammar}S%d.txt
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -j 2 -n 5 -d 10 -o {tmpdir}/{grammar}M%d.txt
+// TEST-ANTLR: {grammar}.g4 -o {tmpdir}
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}S%d.txt
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}M%d.txt
+
+grammar Specialize;
+
+start
+  : listofelements EOF
+  ;
+
+listofelements
+  : element (' ' element)*
+  | '(' listofelements ')'
+  ;
+
+element
+  : NAME ('?' | '!' items)?
+  ;
+
+items
+  : item (',' item)*
+  ;
+
+item
+  : NAME
+  | NUMBER
+  ;
+
+NAME
+  : [a-z]+
+  ;
+
+NUMBER
+  : [0-9]+ ('.' [0-9]+)?
+  ;
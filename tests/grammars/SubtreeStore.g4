@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+ *
+ * Licensed under the BSD 3-Clause License
+ * <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+ * This file may not be copied, modified, or distributed except
+ * according to those terms.
+ */
+
+/*
+ * This test checks whether the trees added to a subtree store (a population
+ * file with the `.grss` extension) can be reloaded by another run of the
+ * generator and recombined into syntactically correct tests (`--no-generate`,
+ * `--no-mutate` and `--no-edit` CLI options of generator), also if the trees
+ * were generated as flat trees (`--flat-tree` CLI option of generator).
+ */
+
+// TEST-PROCESS: {grammar}.g4 -o {tmpdir}
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -d 10 -j 1 -n 10 --population {tmpdir}/{grammar}.grss --keep-trees --no-mutate --no-recombine --no-edit -o {tmpdir}/{grammar}G%d.txt
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -d 10 -j 1 -n 20 --population {tmpdir}/{grammar}.grss --no-generate --no-mutate --no-edit -o {tmpdir}/{grammar}R%d.txt
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -d 10 -j 1 -n 10 --flat-tree --population {tmpdir}/{grammar}F.grss --keep-trees --no-mutate --no-recombine --no-edit -o {tmpdir}/{grammar}FG%d.txt
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -d 10 -j 1 -n 20 --population {tmpdir}/{grammar}F.grss --no-generate --no-mutate --no-edit -o {tmpdir}/{grammar}FR%d.txt
+// TEST-ANTLR: {grammar}.g4 -o {tmpdir}
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}G%d.txt
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}R%d.txt
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}FR%d.txt
+
+grammar SubtreeStore;
+
+start
+  : pair (';' pair)* EOF
+  ;
+
+pair
+  : key '=' value
+  ;
+
+key
+  : ID
+  ;
+
+value
+  : ID
+  | '{' start '}'
+  ;
+
+ID
+  : [a-z]+
+  ;
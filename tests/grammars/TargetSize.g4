@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+ *
+ * Licensed under the BSD 3-Clause License
+ * <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+ * This file may not be copied, modified, or distributed except
+ * according to those terms.
+ */
+
+/*
+ * This test checks whether the generation steered towards a target size
+ * (`--target-size` CLI option of generator) creates syntactically correct
+ * tests, both with small and large targets, from a grammar with unbounded
+ * recursion and repetitions, and whether the size of the tests stays close to
+ * the target.
+ */
+
+// TEST-PROCESS: {grammar}.g4 -o {tmpdir}
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -j 1 -n 5 --target-size 10 --random-seed 1 -o {tmpdir}/{grammar}S%d.txt
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -j 1 -n 5 --target-size 1000 --random-seed 1 -o {tmpdir}/{grammar}L%d.txt
+// TEST-CHECK: size --max 20 {tmpdir}/{grammar}S%d.txt
+// TEST-CHECK: size --min 500 --max 1200 {tmpdir}/{grammar}L%d.txt
+// TEST-ANTLR: {grammar}.g4 -o {tmpdir}
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}S%d.txt
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}L%d.txt
+
+grammar TargetSize;
+
+start
+  : list EOF
+  ;
+
+list
+  : item (' ' item)*
+  ;
+
+item
+  : NAME
+  | '(' list ')'
+  | '[' item (',' item)* ']'
+  ;
+
+NAME
+  : [a-z]+
+  ;
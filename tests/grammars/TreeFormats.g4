@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2021 Renata Hodovan, Akos Kiss.
+ *
+ * Licensed under the BSD 3-Clause License
+ * <LICENSE.rst or https://opensource.org/licenses/BSD-3-Clause>.
+ * This file may not be copied, modified, or distributed except
+ * according to those terms.
+ */
+
+/*
+ * This test checks whether the trees saved in the legacy pickle format (grt)
+ * survive a round-trip through the binary tree format (grtb) of converter,
+ * and whether the converted trees can be mutated and recombined into
+ * syntactically correct tests. Flat trees (`--flat-tree` CLI option of
+ * generator) saved in the pickle format are mutated, edited and recombined as
+ * well.
+ */
+
+// TEST-PROCESS: {grammar}.g4 -o {tmpdir}
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -d 10 -j 1 -n 10 --population {tmpdir}/pop --keep-trees --tree-format grt --no-mutate --no-recombine --no-edit -o {tmpdir}/{grammar}G%d.txt
+// TEST-CONVERT: {tmpdir}/pop --tree-format grtb -o {tmpdir}/popb
+// TEST-CONVERT: {tmpdir}/popb --tree-format grt -o {tmpdir}/popt
+// TEST-CHECK: trees {tmpdir}/pop/{grammar}G%d.txt.grt {tmpdir}/popb/{grammar}G%d.txt.grtb
+// TEST-CHECK: trees {tmpdir}/pop/{grammar}G%d.txt.grt {tmpdir}/popt/{grammar}G%d.txt.grt
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -d 10 -j 1 -n 20 --population {tmpdir}/popb --no-generate --no-edit -o {tmpdir}/{grammar}M%d.txt
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -d 10 -j 1 -n 10 --flat-tree --population {tmpdir}/popf --keep-trees --tree-format grt --no-mutate --no-recombine --no-edit -o {tmpdir}/{grammar}FG%d.txt
+// TEST-GENERATE: {grammar}Generator.{grammar}Generator -r start -d 10 -j 1 -n 20 --flat-tree --population {tmpdir}/popf --no-generate -o {tmpdir}/{grammar}FM%d.txt
+// TEST-ANTLR: {grammar}.g4 -o {tmpdir}
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}G%d.txt
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}M%d.txt
+// TEST-PARSE: -p {grammar}Parser -l {grammar}Lexer -r start {tmpdir}/{grammar}FM%d.txt
+
+grammar TreeFormats;
+
+start
+  : element+ EOF
+  ;
+
+element
+  : '<' NAME attribute* '>' content '</' NAME '>'
+  | '<' NAME attribute* '/>'
+  ;
+
+attribute
+  : ' ' NAME '="' TEXT? '"'
+  ;
+
+content
+  : (element | TEXT)*
+  ;
+
+NAME
+  : [a-z] [a-z0-9]*
+  ;
+
+TEXT
+  : [a-zA-Z0-9 .,]+
+  ;
@@ -10,6 +10,7 @@ import glob
 import os
 import re
 import shlex
+import shutil
 import subprocess
 import sys
 
@@ -144,11 +145,102 @@ def run_parse(grammar, commandline, tmpdir):
                    tmpdir)
 
 
+def run_check(grammar, commandline, tmpdir):
+    """
+    'CHECK' test command runner. It will call a simple checker of output files
+    with the specified command line. Tests properties of the outputs that are
+    not checked by parsing them (e.g., their sizes or their equality).
+
+    :param grammar: file name of the grammar that contained the test command.
+    :param commandline: command line as specified in the test command.
+    :param tmpdir: path to a temporary directory (provided by the environment).
+    """
+    run_subprocess(grammar,
+                   '{python} {checker} {commandline}'
+                   .format(python=sys.executable, checker=os.path.join(tool_dir, 'check.py'), commandline=commandline),
+                   tmpdir)
+
+
+def run_convert(grammar, commandline, tmpdir):
+    """
+    'CONVERT' test command runner. It will call ``grammarinator-convert`` with
+    the specified command line. Tests whether saved trees can be converted
+    between the tree formats and populations.
+
+    :param grammar: file name of the grammar that contained the test command.
+    :param commandline: command line as specified in the test command.
+    :param tmpdir: path to a temporary directory (provided by the environment).
+    """
+    run_subprocess(grammar,
+                   '{python} -m grammarinator.convert {commandline}'
+                   .format(python=sys.executable, commandline=commandline),
+                   tmpdir)
+
+
+def run_minimize(grammar, commandline, tmpdir):
+    """
+    'MINIMIZE' test command runner. It will call ``grammarinator-minimize``
+    with the specified command line. Tests whether populations can be
+    deduplicated and reduced.
+
+    :param grammar: file name of the grammar that contained the test command.
+    :param commandline: command line as specified in the test command.
+    :param tmpdir: path to a temporary directory (provided by the environment).
+    """
+    run_subprocess(grammar,
+                   '{python} -m grammarinator.minimize {commandline}'
+                   .format(python=sys.executable, commandline=commandline),
+                   tmpdir)
+
+
+def run_feedback(grammar, commandline, tmpdir):
+    """
+    'FEEDBACK' test command runner. It will call a simple in-process harness
+    giving feedback to the generator with the specified command line. Tests
+    whether the weights learned from the feedback are saved and reloaded.
+
+    :param grammar: file name of the grammar that contained the test command.
+    :param commandline: command line as specified in the test command.
+    :param tmpdir: path to a temporary directory (provided by the environment).
+    """
+    run_subprocess(grammar,
+                   '{python} {harness} {commandline}'
+                   .format(python=sys.executable, harness=os.path.join(tool_dir, 'feedback.py'), commandline=commandline),
+                   tmpdir)
+
+
+def run_cxx(grammar, commandline, tmpdir):
+    """
+    'CXX' test command runner. It will call the C++ compiler (the one set in
+    the ``CXX`` environment variable, or the first one found of ``c++``,
+    ``g++`` and ``clang++``) with the specified command line. Tests whether
+    the code generated for the C++ target compiles. The command is skipped
+    if no compiler is available.
+
+    :param grammar: file name of the grammar that contained the test command.
+    :param commandline: command line as specified in the test command.
+    :param tmpdir: path to a temporary directory (provided by the environment).
+    """
+    compiler = os.environ.get('CXX') or next(filter(None, (shutil.which(cxx) for cxx in ['c++', 'g++', 'clang++'])), None)
+    if not compiler:
+        print('SKIP: no C++ compiler found')
+        return
+    run_subprocess(grammar,
+                   '{compiler} {commandline}'
+                   .format(compiler=compiler, commandline=commandline),
+                   tmpdir)
+
+
 command_runner = {
     "PROCESS": run_process,
     "GENERATE": run_generate,
     "ANTLR": run_antlr,
     "PARSE": run_parse,
+    "CHECK": run_check,
+    "CONVERT": run_convert,
+    "MINIMIZE": run_minimize,
+    "FEEDBACK": run_feedback,
+    "CXX": run_cxx,
 }
 
 
@@ -159,13 +251,56 @@ def run_grammar(grammar, commands, tmpdir):
 
     :param grammar: file name of the grammar that contained the test commands.
     :param commands: an array of tuples of commands and command lines. Valid
-        test commands are 'PROCESS', 'GENERATE', 'ANTLR', and 'PARSE'.
+        test commands are 'PROCESS', 'GENERATE', 'ANTLR', 'PARSE', 'CHECK',
+        'CONVERT', 'MINIMIZE', 'FEEDBACK', and 'CXX'.
     :param tmpdir: path to a temporary directory (provided by the environment).
     """
     for command, commandline in commands:
         command_runner[command](grammar, commandline, tmpdir)
 
 
+def compare_flat_tree(grammar, commands, tmpdir):
+    """
+    Run the 'GENERATE' test commands of a grammar both with object trees and
+    with flat trees (``--flat-tree`` CLI option of generator) from the same
+    random seed, and check whether the outputs are the same. The 'PROCESS'
+    commands are run to create the fuzzers, the other commands are skipped,
+    as well as the 'GENERATE' commands that use a population or a time budget
+    (whose results depend on the previous runs or on timing).
+
+    :param grammar: file name of the grammar that contained the test commands.
+    :param commands: an array of tuples of commands and command lines.
+    :param tmpdir: path to a temporary directory (provided by the environment).
+    """
+    for cnt, (command, commandline) in enumerate(commands):
+        if command == 'PROCESS':
+            run_process(grammar, commandline, tmpdir)
+            continue
+
+        args = shlex.split(commandline, posix=sys.platform != 'win32')
+        if command != 'GENERATE' or any(arg in args for arg in ['--population', '--max-time', '--flat-tree']):
+            continue
+
+        out_idx = next(i for i, arg in enumerate(args) if arg in ['-o', '--out']) + 1
+        out_pattern = os.path.basename(args[out_idx])
+        if '--random-seed' not in args:
+            args += ['--random-seed', '1']
+
+        outputs = []
+        for tree in ['object', 'flat']:
+            out_dir = os.path.join(tmpdir, 'compare{cnt}'.format(cnt=cnt), tree)
+            os.makedirs(out_dir, exist_ok=True)
+            args[out_idx] = os.path.join(out_dir, out_pattern)
+            run_generate(grammar, ' '.join(shlex.quote(arg) for arg in args + (['--flat-tree'] if tree == 'flat' else [])), tmpdir)
+            output = dict()
+            for fn in os.listdir(out_dir):
+                with open(os.path.join(out_dir, fn), 'rb') as f:
+                    output[fn] = f.read()
+            outputs.append(output)
+        assert outputs[0], 'No tests generated by: %s' % commandline
+        assert outputs[0] == outputs[1], 'Outputs of object and flat trees differ for: %s' % commandline
+
+
 def execute():
     """CLI entry point."""
     parser = argparse.ArgumentParser(description='Grammarinator: Grammar Test Command Runner')
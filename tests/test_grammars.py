@@ -8,7 +8,7 @@
 import os
 import pytest
 
-from run_grammars import collect_grammar_commands, run_grammar
+from run_grammars import collect_grammar_commands, compare_flat_tree, run_grammar
 
 
 grammars_dir = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'grammars')
@@ -17,3 +17,8 @@ grammars_dir = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'grammar
 @pytest.mark.parametrize('grammar, commands', collect_grammar_commands(grammars_dir))
 def test_grammar(grammar, commands, tmpdir):
     run_grammar(grammar, commands, str(tmpdir))
+
+
+@pytest.mark.parametrize('grammar, commands', [(grammar, commands) for grammar, commands in collect_grammar_commands(grammars_dir) if any(command == 'GENERATE' for command, _ in commands)])
+def test_flat_tree(grammar, commands, tmpdir):
+    compare_flat_tree(grammar, commands, str(tmpdir))